@@ -2,7 +2,23 @@
 
 #include "ARPG.h"
 #include "Modules/ModuleManager.h"
+#include "Core/ARPGReplicationGraph.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ARPG, "ARPG" );
+class FARPGModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Lets the game net driver use the replication graph without a ReplicationDriverClassName config entry
+		UReplicationDriver::CreateReplicationDriverDelegate().BindStatic(&UARPGReplicationGraph::CreateReplicationDriver);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FARPGModule, ARPG, "ARPG" );
 
 DEFINE_LOG_CATEGORY(LogARPG)
\ No newline at end of file
@@ -2,13 +2,46 @@
 
 
 #include "ARPGAbilitySet.h"
+#include "AbilitySystemGlobals.h"
 
 UARPGAbilitySet::UARPGAbilitySet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
+#if WITH_EDITOR
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		FCoreUObjectDelegates::OnObjectsReinstanced.AddUObject(this, &UARPGAbilitySet::HandleObjectsReinstanced);
+	}
+#endif
+}
+
+void UARPGAbilitySet::BeginDestroy()
+{
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReinstanced.RemoveAll(this);
+#endif
+
+	Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UARPGAbilitySet::HandleObjectsReinstanced(const TMap<UObject*, UObject*>& OldToNewInstanceMap)
+{
+	GrantPlan.Reset();
+}
+
+void UARPGAbilitySet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// The authored data changed, so the plan will be rebuilt the next time the set is granted
+	GrantPlan.Reset();
 }
+#endif
 
 void UARPGAbilitySet::GiveToAbilitySystem(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles, UObject* SourceObject) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_ARPGAbilitySet_GiveToAbilitySystem);
+
 	if (!ASC)
 	{
 		UE_LOGFMT(LogTemp, Log, "Tried to grant ability set, but the provided ASC was null.");
@@ -21,9 +54,84 @@ void UARPGAbilitySet::GiveToAbilitySystem(UARPGAbilitySystemComponent* ASC, FARP
 		return;
 	}
 
-	GrantAttributeSets(ASC, OutGrantedHandles);
-	GrantGameplayEffects(ASC, OutGrantedHandles);
-	GrantGameplayAbilities(ASC, OutGrantedHandles, SourceObject);
+	const FARPGAbilitySet_GrantPlan& Plan = GetGrantPlan();
+
+	// Size everything up front so granting doesn't grow arrays one element at a time
+	OutGrantedHandles.AbilitySpecHandles.Reserve(OutGrantedHandles.AbilitySpecHandles.Num() + Plan.Abilities.Num());
+	OutGrantedHandles.GameplayEffectHandles.Reserve(OutGrantedHandles.GameplayEffectHandles.Num() + Plan.Effects.Num());
+	OutGrantedHandles.GrantedAttributeSets.Reserve(OutGrantedHandles.GrantedAttributeSets.Num() + Plan.AttributeSets.Num());
+	ASC->ReserveAbilitySpecs(Plan.Abilities.Num());
+
+	GrantAttributeSets(Plan, ASC, OutGrantedHandles);
+	GrantGameplayEffects(Plan, ASC, OutGrantedHandles);
+	GrantGameplayAbilities(Plan, ASC, OutGrantedHandles, SourceObject);
+}
+
+const FARPGAbilitySet_GrantPlan& UARPGAbilitySet::GetGrantPlan() const
+{
+	check(IsInGameThread());
+
+	if (!GrantPlan.bIsBuilt)
+	{
+		BuildGrantPlan();
+	}
+
+	return GrantPlan;
+}
+
+void UARPGAbilitySet::BuildGrantPlan() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGAbilitySet_BuildGrantPlan);
+
+	GrantPlan.Reset();
+	GrantPlan.Abilities.Reserve(GrantedGameplayAbilities.Num());
+	GrantPlan.Effects.Reserve(GrantedGameplayEffects.Num());
+	GrantPlan.AttributeSets.Reserve(GrantedAttributes.Num());
+
+	for (const FARPGAbilitySet_GameplayAbility& AbilityToGrant : GrantedGameplayAbilities)
+	{
+		if (!IsValid(AbilityToGrant.Ability))
+		{
+			UE_LOGFMT(LogTemp, Error, "Ability set {0} has a gameplay ability entry with an invalid ability class, skipping this one", GetName());
+			continue;
+		}
+
+		if (!AbilityToGrant.InputTag.IsValid())
+		{
+			UE_LOGFMT(LogTemp, Error, "Ability set {0} grants {1}, but the associated input tag was invalid.", GetName(), AbilityToGrant.Ability->GetName());
+		}
+
+		FARPGAbilitySet_GrantPlan::FAbilityEntry& Entry = GrantPlan.Abilities.AddDefaulted_GetRef();
+		Entry.AbilityClass = AbilityToGrant.Ability;
+		Entry.AbilityLevel = AbilityToGrant.AbilityLevel;
+		Entry.InputTag = AbilityToGrant.InputTag;
+	}
+
+	for (const FARPGAbilitySet_GameplayEffect& EffectToGrant : GrantedGameplayEffects)
+	{
+		if (!IsValid(EffectToGrant.GameplayEffect))
+		{
+			UE_LOGFMT(LogTemp, Log, "Ability set {0} has a gameplay effect entry with an invalid effect class, skipping this one.", GetName());
+			continue;
+		}
+
+		FARPGAbilitySet_GrantPlan::FEffectEntry& Entry = GrantPlan.Effects.AddDefaulted_GetRef();
+		Entry.EffectClass = EffectToGrant.GameplayEffect;
+		Entry.EffectLevel = EffectToGrant.EffectLevel;
+	}
+
+	for (const FARPGAbilitySet_AttributeSet& SetToGrant : GrantedAttributes)
+	{
+		if (!IsValid(SetToGrant.AttributeSet))
+		{
+			UE_LOGFMT(LogTemp, Log, "Ability set {0} has an invalid attribute set entry, skipping it.", GetName());
+			continue;
+		}
+
+		GrantPlan.AttributeSets.AddUnique(SetToGrant.AttributeSet);
+	}
+
+	GrantPlan.bIsBuilt = true;
 }
 
 const TArray<FARPGAbilitySet_GameplayAbility>& UARPGAbilitySet::GetGameplayAbilities() const
@@ -51,34 +159,24 @@ void FARPGAbilitySet_GrantedHandles::TakeAbilityFromAbilitySystem(UARPGAbilitySy
 {
 }
 
+void FARPGAbilitySet_GrantPlan::Reset()
+{
+	Abilities.Reset();
+	Effects.Reset();
+	AttributeSets.Reset();
+	bIsBuilt = false;
+}
+
 
 
-void UARPGAbilitySet::GrantGameplayAbilities(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles, UObject* SourceObject) const
+void UARPGAbilitySet::GrantGameplayAbilities(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles, UObject* SourceObject) const
 {
 	check(ASC);
 
-	// Add gameplay abilities
-	for (int32 AbilityIndex = 0; AbilityIndex < GrantedGameplayAbilities.Num(); ++AbilityIndex)
+	for (const FARPGAbilitySet_GrantPlan::FAbilityEntry& Entry : Plan.Abilities)
 	{
-		const FARPGAbilitySet_GameplayAbility& AbilityToGrant = GrantedGameplayAbilities[AbilityIndex];
-
-		if (!IsValid(AbilityToGrant.Ability))
-		{
-			UE_LOGFMT(LogTemp, Error, "Tried to grant a gameplay ability from an ability set, but the pointer to the underlying gameplay ability is invalid, skipping this one");
-			continue;
-		}
-
-		if (!AbilityToGrant.InputTag.IsValid())
-		{
-			UE_LOG(LogTemp, Error, TEXT("Tried to grant a gameplay ability but the associated input tag was invalid."));
-		}
-
-		// Get CDO of the ability
-		UARPGAbility* AbilityCDO = AbilityToGrant.Ability->GetDefaultObject<UARPGAbility>();
-
-		FGameplayAbilitySpec AbilitySpec(AbilityCDO, AbilityToGrant.AbilityLevel);
-		AbilitySpec.SourceObject = SourceObject;
-		AbilitySpec.GetDynamicSpecSourceTags().AddTag(AbilityToGrant.InputTag);
+		FGameplayAbilitySpec AbilitySpec(Entry.AbilityClass->GetDefaultObject<UARPGAbility>(), Entry.AbilityLevel, INDEX_NONE, SourceObject);
+		AbilitySpec.GetDynamicSpecSourceTags().AddTag(Entry.InputTag);
 
 		const FGameplayAbilitySpecHandle AbilitySpecHandle = ASC->GiveAbility(AbilitySpec);
 
@@ -86,67 +184,55 @@ void UARPGAbilitySet::GrantGameplayAbilities(UARPGAbilitySystemComponent* ASC, F
 	}
 }
 
-void UARPGAbilitySet::GrantGameplayEffects(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const
+void UARPGAbilitySet::GrantGameplayEffects(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const
 {
 	check(ASC);
 
-	for (int32 EffectIndex = 0; EffectIndex < GrantedGameplayEffects.Num(); ++EffectIndex)
+	if (Plan.Effects.Num() == 0)
 	{
-		const FARPGAbilitySet_GameplayEffect& EffectToGrant = GrantedGameplayEffects[EffectIndex];
+		return;
+	}
 
-		if (!IsValid(EffectToGrant.GameplayEffect))
-		{
-			UE_LOGFMT(LogTemp, Log, "Tried to grant a gameplay effect from an ability set, but the pointer to the underlying gameplay effect is invalid, skipping this one.");
-			continue;
-		}
+	// Every effect granted by the set shares the same instigator, so one context is enough for all of them
+	FGameplayEffectContextHandle EffectContextHandle(UAbilitySystemGlobals::Get().AllocGameplayEffectContext());
+	EffectContextHandle.AddInstigator(ASC->GetOwnerActor(), ASC->GetAvatarActor());
 
-		// Get CDO for the gameplay effect
-		UGameplayEffect* Effect = EffectToGrant.GameplayEffect.GetDefaultObject();
-		if (!IsValid(Effect))
+	for (const FARPGAbilitySet_GrantPlan::FEffectEntry& Entry : Plan.Effects)
+	{
+		const UGameplayEffect* EffectCDO = Entry.EffectClass->GetDefaultObject<UGameplayEffect>();
+		if (!IsValid(EffectCDO))
 		{
-			UE_LOGFMT(LogTemp, Log, "Tried to grant a gameplay effect, but the underlying CDO for the gameplay effect's class is invalid, skipping this one.");
+			UE_LOGFMT(LogTemp, Log, "Ability set {0} has a gameplay effect whose CDO is invalid, skipping this one.", GetName());
 			continue;
 		}
 
-		FGameplayEffectContextHandle EffectContextHandle;
-		EffectContextHandle.AddInstigator(ASC->GetOwnerActor(), ASC->GetAvatarActor());
+		const FGameplayEffectSpec EffectSpec(EffectCDO, EffectContextHandle, Entry.EffectLevel);
 
-		FGameplayEffectSpec EffectSpec = FGameplayEffectSpec(EffectToGrant.GameplayEffect.GetDefaultObject(), EffectContextHandle, EffectToGrant.EffectLevel);
+		const FActiveGameplayEffectHandle ActiveEffectHandle = ASC->ApplyGameplayEffectSpecToSelf(EffectSpec);
 
-		FActiveGameplayEffectHandle ActiveEffectHandle = ASC->ApplyGameplayEffectSpecToSelf(EffectSpec);
-
-		UE_LOGFMT(LogTemp, Log, "Applied gameplay effect {0} to an ASC.", Effect->GetName());
+		UE_LOGFMT(LogTemp, Verbose, "Applied gameplay effect {0} to an ASC.", EffectCDO->GetName());
 
 		OutGrantedHandles.AddGameplayEffectHandle(ActiveEffectHandle);
 	}
-
 }
-void UARPGAbilitySet::GrantAttributeSets(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const
+
+void UARPGAbilitySet::GrantAttributeSets(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const
 {
 	check(ASC);
 
-	for (int32 SetIndex = 0; SetIndex < GrantedAttributes.Num(); ++SetIndex)
+	for (const TSubclassOf<UAttributeSet>& SetClass : Plan.AttributeSets)
 	{
-		const FARPGAbilitySet_AttributeSet& SetToGrant = GrantedAttributes[SetIndex];
-
-		if (!IsValid(SetToGrant.AttributeSet))
+		// Not an error: characters commonly create their core attribute sets as default subobjects
+		if (ASC->GetAttributeSet(SetClass))
 		{
-			UE_LOGFMT(LogTemp, Log, "Tried to grant an invalid attribute set, skipping it.");
 			continue;
 		}
 
-		bool SetAlreadyExists = IsValid(ASC->GetAttributeSet(SetToGrant.AttributeSet));
-		if (SetAlreadyExists)
-		{
-			UE_LOGFMT(LogTemp, Log, "Tried to grant an attribute set to an ASC, but the ASC already has an attribute set of the same UClass. Skipping it.");
-			continue;
-		}
-
-		UAttributeSet* NewSet = NewObject<UAttributeSet>(ASC->GetOwner(), SetToGrant.AttributeSet);
+		UAttributeSet* NewSet = NewObject<UAttributeSet>(ASC->GetOwner(), SetClass);
 		ASC->AddAttributeSetSubobject(NewSet);
 
-		UE_LOGFMT(LogTemp, Log, "Granted attribute set {0} to an ASC.", NewSet->GetName());
+		UE_LOGFMT(LogTemp, Verbose, "Granted attribute set {0} to an ASC.", NewSet->GetName());
 
 		OutGrantedHandles.AddAttributeSet(NewSet);
 	}
-}
\ No newline at end of file
+}
@@ -20,6 +20,11 @@ class UARPGAbilitySystemComponent;
 class UGameplayEffect;
 struct FGameplayAbilitySpecHandle;
 
+DECLARE_STATS_GROUP(TEXT("ARPGAbilities"), STATGROUP_ARPGAbilities, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Ability Set Give To Ability System"), STAT_ARPGAbilitySet_GiveToAbilitySystem, STATGROUP_ARPGAbilities);
+DECLARE_CYCLE_STAT(TEXT("Ability Set Build Grant Plan"), STAT_ARPGAbilitySet_BuildGrantPlan, STATGROUP_ARPGAbilities);
+
 /**
  * FARPGAbilitySet_GameplayAbility
  *
@@ -121,6 +126,49 @@ struct FARPGAbilitySet_GrantedHandles
 };
 
 
+/**
+ * FARPGAbilitySet_GrantPlan
+ *
+ *	Pre-resolved version of the data authored on an UARPGAbilitySet.
+ *
+ *	Validating the authored arrays and logging about bad entries only needs to happen once per asset, not
+ *	once per character that receives the set. The plan is built the first time the set is granted, and
+ *	GiveToAbilitySystem only walks the plan. Invalid entries are dropped while building.
+ *
+ *	Entries keep classes rather than CDOs, the CDOs are resolved when granting so that a plan never
+ *	refers to the CDO of a class that wasn't fully loaded or has since been recompiled.
+ */
+struct FARPGAbilitySet_GrantPlan
+{
+	struct FAbilityEntry
+	{
+		// Ability class to grant
+		TSubclassOf<UARPGAbility> AbilityClass;
+
+		int32 AbilityLevel = 1;
+
+		FGameplayTag InputTag;
+	};
+
+	struct FEffectEntry
+	{
+		// Gameplay effect class to apply
+		TSubclassOf<UGameplayEffect> EffectClass;
+
+		float EffectLevel = 1.f;
+	};
+
+	TArray<FAbilityEntry> Abilities;
+	TArray<FEffectEntry> Effects;
+	TArray<TSubclassOf<UAttributeSet>> AttributeSets;
+
+	// False until the plan has been built from the authored data
+	bool bIsBuilt = false;
+
+	void Reset();
+};
+
+
 /**
  * UARPGAbilitySet
  *
@@ -138,6 +186,13 @@ public:
 
 	UARPGAbilitySet(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
+	//~ Begin UObject
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	//~ End UObject
+
 	// Grants the ability set to the specified ability system component.
 	// The returned handles can be used later to take away anything that was granted.
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
@@ -151,15 +206,29 @@ public:
 	const TArray<FARPGAbilitySet_GameplayAbility>& GetGameplayAbilities() const;
 
 
+	/**
+	 * Returns the pre-resolved grant plan for this set, building it first if needed.
+	 * Should only be called from the game thread.
+	 */
+	const FARPGAbilitySet_GrantPlan& GetGrantPlan() const;
+
 protected:
-	// Grant all abilities in this set to the provided ASC
-	void GrantGameplayAbilities(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles, UObject* SourceObject) const;
+	// Validates the authored arrays and resolves them into GrantPlan
+	void BuildGrantPlan() const;
+
+#if WITH_EDITOR
+	// Blueprint classes in the plan may have been recompiled, drop the plan so it gets rebuilt
+	void HandleObjectsReinstanced(const TMap<UObject*, UObject*>& OldToNewInstanceMap);
+#endif
 
-	// Grant (apply) all gameplay effects in this set to the provided ASC
-	void GrantGameplayEffects(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const;
+	// Grant all abilities in the plan to the provided ASC
+	void GrantGameplayAbilities(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles, UObject* SourceObject) const;
 
-	// Grant all attribute sets in this set to the provided ASC
-	void GrantAttributeSets(UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const;
+	// Grant (apply) all gameplay effects in the plan to the provided ASC
+	void GrantGameplayEffects(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const;
+
+	// Grant all attribute sets in the plan to the provided ASC
+	void GrantAttributeSets(const FARPGAbilitySet_GrantPlan& Plan, UARPGAbilitySystemComponent* ASC, FARPGAbilitySet_GrantedHandles& OutGrantedHandles) const;
 
 	// Gameplay abilities to grant when this ability set is granted.
 	UPROPERTY(EditDefaultsOnly, Category = "Abilities", meta = (TitleProperty = Ability))
@@ -172,4 +241,10 @@ protected:
 	// Attribute sets to grant when this ability set is granted.
 	UPROPERTY(EditDefaultsOnly, Category = "Attribute Sets", meta = (TitleProperty = AttributeSet))
 	TArray<FARPGAbilitySet_AttributeSet> GrantedAttributes;
+
+private:
+	friend class FARPGAbilitySetGrantPlanTest;
+
+	// Cached result of BuildGrantPlan. Mutable since the set itself is a const data asset.
+	mutable FARPGAbilitySet_GrantPlan GrantPlan;
 };
\ No newline at end of file
@@ -178,6 +178,18 @@ void UARPGAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 	InputReleasedSpecHandles.Reset();
 }
 
+void UARPGAbilitySystemComponent::ReserveAbilitySpecs(int32 NumSpecs)
+{
+	if (NumSpecs > 0)
+	{
+		ActivatableAbilities.Items.Reserve(ActivatableAbilities.Items.Num() + NumSpecs);
+	}
+}
+
+bool UARPGAbilitySystemComponent::UsesCompactAttributeStorage() const
+{
+	return bAllowCompactAttributeStorage && ReplicationMode == EGameplayEffectReplicationMode::Minimal;
+}
 
 void UARPGAbilitySystemComponent::ClearAbilityInput()
 {
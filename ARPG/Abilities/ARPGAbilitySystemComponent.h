@@ -44,6 +44,25 @@ public:
 	 */
 	virtual void ProcessAbilityInput(float DeltaTime, bool bGamePaused);
 
+	/**
+	 * @brief Grows the activatable ability list so that the next NumSpecs calls to GiveAbility don't reallocate.
+	 *		  Used when granting whole ability sets at once.
+	 */
+	void ReserveAbilitySpecs(int32 NumSpecs);
+
+	/**
+	 * @brief Returns true if this ASC stores its attributes in compact mode.
+	 *		  In compact mode, starting attributes are written straight into the attribute sets instead of going
+	 *		  through initialization gameplay effects, so no active effects or aggregators are created for them.
+	 *		  Only ASCs in Minimal replication mode (i.e., non-player characters) can use compact storage.
+	 */
+	bool UsesCompactAttributeStorage() const;
+
+protected:
+	/** Allow compact attribute storage when this ASC is in Minimal replication mode */
+	UPROPERTY(EditDefaultsOnly, Category = "Attributes")
+	bool bAllowCompactAttributeStorage = true;
+
 private:
 	/** Array of ability specs that had their input pressed this frame and are waiting to be processed */
 	TArray<FGameplayAbilitySpecHandle> InputPressedSpecHandles;
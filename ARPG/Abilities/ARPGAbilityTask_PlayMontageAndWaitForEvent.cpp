@@ -3,6 +3,28 @@
 #include "ARPGAbilityTask_PlayMontageAndWaitForEvent.h"
 #include "GameFramework/Character.h"
 #include "ARPGAbilitySystemComponent.h"
+#include "GameplayTagsManager.h"
+#include "GameFramework/PlayerState.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimNotifyQueue.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ARPGMontageTask
+{
+	static TAutoConsoleVariable<bool> CVarServerCatchUp(
+		TEXT("ARPG.Montage.ServerCatchUp"),
+		true,
+		TEXT("If true, the server starts montages of locally predicted abilities half a round trip in, where the predicting client already is, instead of from the start. Notifies in the skipped part are triggered right away."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarMaxServerCatchUp(
+		TEXT("ARPG.Montage.MaxServerCatchUp"),
+		0.25f,
+		TEXT("Maximum time in seconds the server fast-forwards a predicted montage by."),
+		ECVF_Default);
+}
+
+const FGameplayEventData UARPGAbilityTask_PlayMontageAndWaitForEvent::EmptyEventData;
 
 UARPGAbilityTask_PlayMontageAndWaitForEvent::
 UARPGAbilityTask_PlayMontageAndWaitForEvent(
@@ -11,6 +33,8 @@ UARPGAbilityTask_PlayMontageAndWaitForEvent(
 {
 	Rate = 1.f;
 	bStopWhenAbilityEnds = true;
+	StartTimeSeconds = 0.f;
+	bAllowInterruptAfterBlendOut = false;
 }
 
 // 1. We are gonna need to start playing animation montage
@@ -24,8 +48,6 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::Activate()
 		return;
 	}
 
-	bool bIsLocallyControlled = Ability->IsLocallyControlled();
-	
 	UARPGAbilitySystemComponent* ASC = GetTargetASC();
 	if (!ASC)
 	{
@@ -42,14 +64,40 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::Activate()
 	}
 
 	// Bind to event callback
-	EventHandle = ASC->AddGameplayEventTagContainerDelegate(
-		EventTags,
-		FGameplayEventTagMulticastDelegate::FDelegate::CreateUObject(
-			this, &UARPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent)
-	);
-
-	// Start playing the animation montage
-	bool bPlayedMontage = ASC->PlayMontage(Ability, Ability->GetCurrentActivationInfo(), MontageToPlay, Rate, StartSection) > 0.f;
+	if (EventTags.IsEmpty())
+	{
+		// Listening to everything, the container delegates are the only way to do that
+		EventHandle = ASC->AddGameplayEventTagContainerDelegate(
+			EventTags,
+			FGameplayEventTagMulticastDelegate::FDelegate::CreateUObject(
+				this, &UARPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent)
+		);
+	}
+	else
+	{
+		// Container delegates are matched (and the whole delegate list copied) for every event the ASC receives.
+		// Expand the filter to the tags and their children once instead, and register each in the ASC's per-tag callback map,
+		// so events are routed to us with a single hash lookup.
+		FGameplayTagContainer RoutedTags = EventTags;
+		for (const FGameplayTag& Tag : EventTags)
+		{
+			RoutedTags.AppendTags(UGameplayTagsManager::Get().RequestGameplayTagChildren(Tag));
+		}
+
+		for (const FGameplayTag& Tag : RoutedTags)
+		{
+			const FDelegateHandle Handle = ASC->GenericGameplayEventCallbacks.FindOrAdd(Tag).AddUObject(
+				this, &UARPGAbilityTask_PlayMontageAndWaitForEvent::OnRoutedGameplayEvent, Tag);
+			RoutedEventHandles.Emplace(Tag, Handle);
+		}
+	}
+
+	// Start playing the animation montage. The start section is folded into the start position so playback starts where
+	// it should right away, instead of starting at 0 and jumping (and replicating both).
+	bInterruptBroadcast = false;
+	const float RequestedStartPosition = GetMontageStartPosition();
+	const float StartPosition = MontageToPlay ? FMath::Min(RequestedStartPosition + GetServerCatchUp(), MontageToPlay->GetPlayLength()) : RequestedStartPosition;
+	bool bPlayedMontage = ASC->PlayMontage(Ability, Ability->GetCurrentActivationInfo(), MontageToPlay, Rate, NAME_None, StartPosition) > 0.f;
 	
 	// If we failed to play the montage, log out error and broadcast cancel delegate
 	if (!bPlayedMontage)
@@ -57,7 +105,7 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::Activate()
 		UE_LOG(LogTemp, Warning, TEXT("URPGAbilityTask_PlayMontageAndWaitForEvent called in Ability %s failed to play montage %s; Task Instance Name %s."), *Ability->GetName(), *GetNameSafe(MontageToPlay), *InstanceName.ToString());
 		if (ShouldBroadcastAbilityTaskDelegates())
 		{
-			OnCancelled.Broadcast(FGameplayTag(), FGameplayEventData());
+			OnCancelled.Broadcast(FGameplayTag(), EmptyEventData);
 		}
 		return;
 	}
@@ -90,6 +138,12 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::Activate()
 		Character->SetAnimRootMotionTranslationScale(AnimRootMotionTranslationScale);
 	}
 
+	// Everything is bound, the skipped notifies may send events, end the ability or stop the montage
+	if (StartPosition > RequestedStartPosition)
+	{
+		TriggerSkippedNotifies(*AnimInstance, RequestedStartPosition, StartPosition);
+	}
+
 	SetWaitingOnAvatar();
 
 	return;
@@ -124,8 +178,20 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnDestroy(bool AbilityEnded)
 	UARPGAbilitySystemComponent* ASC = GetTargetASC();
 	if (ASC)
 	{
-		ASC->RemoveGameplayEventTagContainerDelegate(EventTags, EventHandle);
+		if (EventHandle.IsValid())
+		{
+			ASC->RemoveGameplayEventTagContainerDelegate(EventTags, EventHandle);
+		}
+
+		for (const TPair<FGameplayTag, FDelegateHandle>& RoutedEventHandle : RoutedEventHandles)
+		{
+			if (FGameplayEventMulticastDelegate* Delegate = ASC->GenericGameplayEventCallbacks.Find(RoutedEventHandle.Key))
+			{
+				Delegate->Remove(RoutedEventHandle.Value);
+			}
+		}
 	}
+	RoutedEventHandles.Reset();
 
 	Super::OnDestroy(AbilityEnded);
 }
@@ -151,10 +217,105 @@ UARPGAbilityTask_PlayMontageAndWaitForEvent::PlayMontageAndWaitForEvent(
 	MyObj->StartSection = StartSection;
 	MyObj->AnimRootMotionTranslationScale = AnimRootMotionTranslationScale;
 	MyObj->bStopWhenAbilityEnds = bStopWhenAbilityEnds;
+	MyObj->StartTimeSeconds = StartTimeSeconds;
+	MyObj->bAllowInterruptAfterBlendOut = bAllowInterruptAfterBlendOut;
 
 	return MyObj;
 }
 
+float UARPGAbilityTask_PlayMontageAndWaitForEvent::GetMontageStartPosition() const
+{
+	if (!MontageToPlay)
+	{
+		return 0.f;
+	}
+
+	float StartPosition = StartTimeSeconds;
+	if (StartSection != NAME_None)
+	{
+		const int32 SectionIndex = MontageToPlay->GetSectionIndex(StartSection);
+		if (SectionIndex != INDEX_NONE)
+		{
+			StartPosition += MontageToPlay->GetAnimCompositeSection(SectionIndex).GetTime();
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("PlayMontageAndWaitForEvent: section %s not found in montage %s."), *StartSection.ToString(), *GetNameSafe(MontageToPlay));
+		}
+	}
+
+	return FMath::Clamp(StartPosition, 0.f, MontageToPlay->GetPlayLength());
+}
+
+float UARPGAbilityTask_PlayMontageAndWaitForEvent::GetServerCatchUp() const
+{
+	// A locally predicted ability started on the client about half a round trip ago. Start the server's montage where
+	// the client's is now, so the position replicated to everyone else doesn't lag behind and force a resync.
+	// Only activations the client actually predicted carry a valid key, server initiated ones start on the server first.
+	const FGameplayAbilityActorInfo* ActorInfo = Ability ? Ability->GetCurrentActorInfo() : nullptr;
+	if (!ARPGMontageTask::CVarServerCatchUp.GetValueOnGameThread() || !ActorInfo || !ActorInfo->IsNetAuthority() || ActorInfo->IsLocallyControlled()
+		|| Ability->GetNetExecutionPolicy() != EGameplayAbilityNetExecutionPolicy::LocalPredicted
+		|| !Ability->GetCurrentActivationInfo().GetActivationPredictionKey().IsValidKey() || Rate <= 0.f)
+	{
+		return 0.f;
+	}
+
+	const APlayerController* PlayerController = ActorInfo->PlayerController.Get();
+	const APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState : nullptr;
+	if (!PlayerState)
+	{
+		return 0.f;
+	}
+
+	const float HalfRoundTrip = PlayerState->GetPingInMilliseconds() * 0.0005f;
+	return FMath::Min(HalfRoundTrip, ARPGMontageTask::CVarMaxServerCatchUp.GetValueOnGameThread()) * Rate;
+}
+
+void UARPGAbilityTask_PlayMontageAndWaitForEvent::GetSkippedNotifies(const UAnimSequenceBase& Animation, float FromPosition, float ToPosition, TArray<const FAnimNotifyEvent*>& OutNotifies)
+{
+	for (const FAnimNotifyEvent& NotifyEvent : Animation.Notifies)
+	{
+		// Notify states still running at the caught-up position begin on the montage's first update, like any state
+		// entered part way through. Only instant notifies would be lost.
+		if (NotifyEvent.NotifyStateClass || (IsRunningDedicatedServer() && !NotifyEvent.bTriggerOnDedicatedServer))
+		{
+			continue;
+		}
+
+		// A notify at ToPosition is at the start of the caught-up montage, the montage's first update treats it like
+		// a notify at the start position of any montage. Between FromPosition and ToPosition, the server would have
+		// triggered it had it started at FromPosition.
+		const float TriggerTime = NotifyEvent.GetTriggerTime();
+		if (TriggerTime >= FromPosition && TriggerTime < ToPosition)
+		{
+			OutNotifies.Add(&NotifyEvent);
+		}
+	}
+}
+
+void UARPGAbilityTask_PlayMontageAndWaitForEvent::TriggerSkippedNotifies(UAnimInstance& AnimInstance, float FromPosition, float ToPosition) const
+{
+	TArray<const FAnimNotifyEvent*> SkippedNotifies;
+	GetSkippedNotifies(*MontageToPlay, FromPosition, ToPosition, SkippedNotifies);
+
+	for (const FAnimNotifyEvent* NotifyEvent : SkippedNotifies)
+	{
+		// A notify may end the ability and stop the montage, the remaining notifies would never have fired then
+		if (!AnimInstance.Montage_IsPlaying(MontageToPlay))
+		{
+			break;
+		}
+
+		if (NotifyEvent->NotifyTriggerChance < 1.f && FMath::FRand() >= NotifyEvent->NotifyTriggerChance)
+		{
+			continue;
+		}
+
+		FAnimNotifyEventReference EventReference(NotifyEvent, MontageToPlay);
+		AnimInstance.TriggerSingleAnimNotify(EventReference);
+	}
+}
+
 UARPGAbilitySystemComponent*
 UARPGAbilityTask_PlayMontageAndWaitForEvent::GetTargetASC() const
 {
@@ -208,7 +369,11 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnMontageBlendingOut(
 	{
 		if (Montage == MontageToPlay)
 		{
-			AbilitySystemComponent->ClearAnimatingAbility(Ability);
+			// When interruptions after blend out are allowed, the ability keeps animating until the montage ends
+			if (bInterrupted || !bAllowInterruptAfterBlendOut)
+			{
+				AbilitySystemComponent->ClearAnimatingAbility(Ability);
+			}
 
 			// Reset AnimRootMotionTranslationScale
 			ACharacter* Character = Cast<ACharacter>(GetAvatarActor());
@@ -225,14 +390,15 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnMontageBlendingOut(
 	{
 		if (ShouldBroadcastAbilityTaskDelegates())
 		{
-			OnInterrupted.Broadcast(FGameplayTag(), FGameplayEventData());
+			bInterruptBroadcast = true;
+			OnInterrupted.Broadcast(FGameplayTag(), EmptyEventData);
 		}
 	}
 	else
 	{
 		if (ShouldBroadcastAbilityTaskDelegates())
 		{
-			OnBlendOut.Broadcast(FGameplayTag(), FGameplayEventData());
+			OnBlendOut.Broadcast(FGameplayTag(), EmptyEventData);
 		}
 	}
 }
@@ -243,7 +409,7 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnAbilityCancelled()
 	{
 		if (ShouldBroadcastAbilityTaskDelegates())
 		{
-			OnCancelled.Broadcast(FGameplayTag(), FGameplayEventData());
+			OnCancelled.Broadcast(FGameplayTag(), EmptyEventData);
 		}
 	}
 }
@@ -255,10 +421,25 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnMontageEnded(UAnimMontage*,
 	{
 		if (ShouldBroadcastAbilityTaskDelegates())
 		{
-			OnCompleted.Broadcast(FGameplayTag(), FGameplayEventData());
+			OnCompleted.Broadcast(FGameplayTag(), EmptyEventData);
+		}
+	}
+	else if (bAllowInterruptAfterBlendOut && !bInterruptBroadcast)
+	{
+		// Interrupted after it started blending out normally
+		if (ShouldBroadcastAbilityTaskDelegates())
+		{
+			bInterruptBroadcast = true;
+			OnInterrupted.Broadcast(FGameplayTag(), EmptyEventData);
 		}
 	}
 
+	// The ability was kept animating through the blend out
+	if (bAllowInterruptAfterBlendOut && Ability && Ability->GetCurrentMontage() == MontageToPlay)
+	{
+		AbilitySystemComponent->ClearAnimatingAbility(Ability);
+	}
+
 	EndTask();
 }
 
@@ -266,13 +447,38 @@ void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent(
 	FGameplayTag EventTag,
 	const FGameplayEventData* Payload)
 {
-	if (ShouldBroadcastAbilityTaskDelegates())
+	BroadcastEventReceived(EventTag, *Payload);
+}
+
+void UARPGAbilityTask_PlayMontageAndWaitForEvent::OnRoutedGameplayEvent(
+	const FGameplayEventData* Payload,
+	FGameplayTag EventTag)
+{
+	BroadcastEventReceived(EventTag, *Payload);
+}
+
+void UARPGAbilityTask_PlayMontageAndWaitForEvent::BroadcastEventReceived(
+	FGameplayTag EventTag,
+	const FGameplayEventData& Payload)
+{
+	if (!ShouldBroadcastAbilityTaskDelegates() || (!EventReceived.IsBound() && !OnEventReceivedNative.IsBound()))
 	{
-		FGameplayEventData TempData = *Payload; // copy data so we don't worry about it being freed unexpectedly after broadcasting
-		TempData.EventTag = EventTag;
+		return;
+	}
 
-		EventReceived.Broadcast(EventTag, TempData);
+	// The ASC keeps the payload alive for the whole broadcast, so it's passed along as is unless its tag needs fixing up
+	if (Payload.EventTag == EventTag)
+	{
+		OnEventReceivedNative.Broadcast(EventTag, Payload);
+		EventReceived.Broadcast(EventTag, Payload);
+		return;
 	}
+
+	FGameplayEventData TaggedPayload = Payload;
+	TaggedPayload.EventTag = EventTag;
+
+	OnEventReceivedNative.Broadcast(EventTag, TaggedPayload);
+	EventReceived.Broadcast(EventTag, TaggedPayload);
 }
 
 FString
@@ -6,7 +6,12 @@
 #include "CoreMinimal.h"
 #include "ARPGAbilityTask_PlayMontageAndWaitForEvent.generated.h"
 
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FARPGPlayMontageAndWaitForEventDelegate, FGameplayTag, EventTag, FGameplayEventData, EventData);
+class UAnimInstance;
+class UAnimSequenceBase;
+struct FAnimNotifyEvent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FARPGPlayMontageAndWaitForEventDelegate, FGameplayTag, EventTag, const FGameplayEventData&, EventData);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FARPGPlayMontageAndWaitForEventNativeDelegate, FGameplayTag /* EventTag */, const FGameplayEventData& /* EventData */);
 
 /**
  * Reference: https://github.com/vahabahmadvand/ActionRPG_UE53/blob/main/Source/ActionRPG/Public/Abilities/RPGAbilityTask_PlayMontageAndWaitForEvent.h
@@ -52,6 +57,11 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FARPGPlayMontageAndWaitForEventDelegate EventReceived;
 
+	/**
+	 * @brief Native version of EventReceived, for C++ abilities. The event data is only valid during the broadcast.
+	 */
+	FARPGPlayMontageAndWaitForEventNativeDelegate OnEventReceivedNative;
+
 	/**
 	 * @brief Start playing an animation montage and wait for it to end.
 	 *	If a gameplay event happens that matches EventTags (or EventTags is empty), the EventReceived delegate will fire with a tag and event data.
@@ -62,6 +72,10 @@ public:
 	 * @param Rate  Change to play the montage faster or slower
 	 * @param bStopWhenAbilityEnds If true, this montage will be aborted if the ability ends normally. It is always stopped when the ability is explicitly cancelled
 	 * @param AnimRootMotionTranslationScale Change to modify size of root motion or set to 0 to block it entirely
+	 * @param StartTimeSeconds Time to start the montage from. Relative to StartSection when one is set, otherwise to the start of the montage.
+	 *	On the server, predicted montages of remote clients are additionally fast-forwarded by half the client's round trip,
+	 *	and the notifies in the skipped part are triggered right away.
+	 * @param bAllowInterruptAfterBlendOut If true, the montage can still be reported as interrupted after it started blending out
 	 * @return
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Ability|Tasks|ARPG",
@@ -73,6 +87,8 @@ public:
 	class UARPGAbilitySystemComponent* GetTargetASC() const;
 
 protected:
+	friend class FARPGMontageCatchUpNotifiesTest;
+
 	UPROPERTY()
 	UAnimMontage* MontageToPlay;
 
@@ -100,6 +116,35 @@ protected:
 	UPROPERTY()
 	bool bStopWhenAbilityEnds;
 
+	/** Time to start the montage from, relative to StartSection if set */
+	UPROPERTY()
+	float StartTimeSeconds;
+
+	/** If true, the ability stays the animating ability during blend out, and interruptions during blend out fire OnInterrupted */
+	UPROPERTY()
+	bool bAllowInterruptAfterBlendOut;
+
+	/** OnInterrupted was already broadcast for this montage */
+	bool bInterruptBroadcast = false;
+
+	/** Returns the position in the montage to start playing from: StartTimeSeconds resolved against StartSection */
+	float GetMontageStartPosition() const;
+
+	/**
+	 * Returns how far into the montage past its start position the server starts it, to catch up with the remote client
+	 * that predicted the activation. 0 for every other activation.
+	 */
+	float GetServerCatchUp() const;
+
+	/**
+	 * Returns the instant notifies of the animation from FromPosition up to, but excluding, ToPosition, i.e. the notifies
+	 * a montage started at ToPosition instead of FromPosition skips. Notify states are left out.
+	 */
+	static void GetSkippedNotifies(const UAnimSequenceBase& Animation, float FromPosition, float ToPosition, TArray<const FAnimNotifyEvent*>& OutNotifies);
+
+	/** Triggers the notifies the server's montage skipped by catching up, so server side notify and gameplay event logic still runs */
+	void TriggerSkippedNotifies(UAnimInstance& AnimInstance, float FromPosition, float ToPosition) const;
+
 	/** Stops currently playing montage and unbinds montage-related delegates, returns true if a montage was stopped, false if not. */
 	bool StopPlayingMontage();
 
@@ -108,8 +153,22 @@ protected:
 	void OnMontageEnded(UAnimMontage*, bool bInterrupted);
 	void OnGameplayEvent(FGameplayTag EventTag, const FGameplayEventData* Payload);
 
+	/** Called through the ASC's per-tag event callbacks, for one of the tags expanded from EventTags */
+	void OnRoutedGameplayEvent(const FGameplayEventData* Payload, FGameplayTag EventTag);
+
+	/** Broadcasts EventReceived and OnEventReceivedNative. Only copies the payload if its EventTag needs fixing up. */
+	void BroadcastEventReceived(FGameplayTag EventTag, const FGameplayEventData& Payload);
+
+	/** Payload passed to the delegates that aren't caused by a gameplay event */
+	static const FGameplayEventData EmptyEventData;
+
 	FOnMontageBlendingOutStarted BlendingOutDelegate;
 	FOnMontageEnded MontageEndedDelegate;
 	FDelegateHandle CancelledHandle;
+
+	/** Handle of the catch-all event delegate, used when EventTags is empty */
 	FDelegateHandle EventHandle;
+
+	/** Handles of the per-tag event callbacks, one per tag matching EventTags */
+	TArray<TPair<FGameplayTag, FDelegateHandle>, TInlineAllocator<4>> RoutedEventHandles;
 };
@@ -2,10 +2,17 @@
 
 
 #include "ARPGAnimNotifyStateWeaponTrace.h"
-#include "Kismet/KismetSystemLibrary.h"
-#include "Components/CapsuleComponent.h"
-#include "Logging/StructuredLog.h"
-#include "DrawDebugHelpers.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Abilities/GameplayAbility.h"
+#include "ARPGDamageBatchSubsystem.h"
+#include "ARPGWeaponTraceSubsystem.h"
+#include "ARPGWeaponTraceDebug.h"
+#include "ARPGWeaponWielder.h"
+#include "ARPG/Core/ARPGCharacter.h"
+#include "GameFramework/GameStateBase.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMeshSocket.h"
 
 UARPGAnimNotifyStateWeaponTrace::UARPGAnimNotifyStateWeaponTrace(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer),
@@ -14,7 +21,6 @@ UARPGAnimNotifyStateWeaponTrace::UARPGAnimNotifyStateWeaponTrace(const FObjectIn
 	WeaponTraceBoxHalfExtent(FVector(40.f, 40.f, 90.f)),
 	bIgnoreSelf(true)
 {
-	WeaponTraceShape = FCollisionShape::MakeBox(WeaponTraceBoxHalfExtent);
 }
 
 void UARPGAnimNotifyStateWeaponTrace::NotifyBegin(
@@ -26,11 +32,12 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyBegin(
 	SCOPE_CYCLE_COUNTER(STAT_ARPGAnimNotifyStateWeaponTrace_NotifyBegin);
 	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
 
-	// Get the character owning the mesh component
-	Character = Cast<AARPGCharacter>(MeshComp->GetOwner());
-	if (!Character)
+	// Get the character owning the mesh component, players and enemies both wield weapons
+	ACharacter* Character = Cast<ACharacter>(MeshComp->GetOwner());
+	const IARPGWeaponWielder* Wielder = Cast<IARPGWeaponWielder>(Character);
+	if (!Wielder)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Character is null in UARPGAnimNotifyStateWeaponTrace::NotifyBegin"));
+		UE_LOG(LogTemp, Verbose, TEXT("%s doesn't wield weapons, skipping weapon trace"), *GetNameSafe(MeshComp->GetOwner()));
 		return;
 	}
 
@@ -40,52 +47,83 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyBegin(
 		return;
 	}
 
-	// Get the weapon mesh from the character
-	WeaponMesh = Character->GetWeaponMesh();
+	// No weapon mesh is a normal state (unarmed, or the weapon mesh is still loading), there's just nothing to trace
+	UStaticMeshComponent* WeaponMesh = Wielder->GetWeaponMesh();
 	if (!WeaponMesh)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to get weapon mesh in UARPGAnimNotifyStateWeaponTrace::NotifyBegin"));
+		UE_LOG(LogTemp, Verbose, TEXT("%s has no weapon mesh, skipping weapon trace"), *Character->GetName());
 		return;
 	}
 
+	UARPGWeaponTraceSubsystem* WeaponTraceSubsystem = UARPGWeaponTraceSubsystem::Get(Character);
+	if (!WeaponTraceSubsystem)
+	{
+		return;
+	}
+
+	// This notify object is shared by everyone playing the animation, so the swing's state is kept per mesh and notify event
+	FARPGWeaponTraceState& State = WeaponTraceSubsystem->AcquireState(MeshComp, EventReference.GetNotify());
+	State.Character = Character;
+	State.WeaponMesh = WeaponMesh;
+	State.Notify = this;
+
+	// A remote client sweeps for its own character and claims its hits, the server only validates them
+	State.bServerValidatesClaims = Character->HasAuthority() && Character->GetRemoteRole() == ROLE_AutonomousProxy
+		&& UARPGWeaponTraceSubsystem::AreClientHitClaimsEnabled();
+
+	// The owning client stamps its claims with this id and the server only checks them against the swing with the same id
+	const bool bClientClaimsHits = Character->GetLocalRole() == ROLE_AutonomousProxy && Cast<AARPGCharacter>(Character);
+	State.ClaimSwingId = (State.bServerValidatesClaims || bClientClaimsHits) ? MakeClaimSwingId(Character, EventReference.GetNotify()) : 0;
+
 	// Initialize collision query parameters
-	CollisionQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponTrace), /* bTraceComplex = */ false);
+	State.CollisionQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponTrace), /* bTraceComplex = */ false);
 
 	// Ignore the character performing the trace to prevent self-hits
 	if (bIgnoreSelf)
 	{
-		CollisionQueryParams.AddIgnoredActor(Character);
+		State.CollisionQueryParams.AddIgnoredActor(Character);
 	}
 
-	// Initialize collision object query parameters
-	CollisionObjectQueryParams = FCollisionObjectQueryParams();
-
 	// Add specified object types to query; default to Pawn if none are specified
 	if (CollisionObjectTypesToQuery.Num() > 0)
 	{
 		for (const auto& ObjectType : CollisionObjectTypesToQuery)
 		{
-			CollisionObjectQueryParams.AddObjectTypesToQuery(ObjectType);
+			State.CollisionObjectQueryParams.AddObjectTypesToQuery(ObjectType);
 		}
 	}
 	else
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No object types specified for collision query. Defaulting to ECC_Pawn."));
-		CollisionObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_Pawn);
+		State.CollisionObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_Pawn);
 	}
 
-	FVector StartLocation = WeaponMesh->GetSocketLocation(WeaponTraceStartSocket);
-	UE_LOGFMT(LogTemp, Log, "START LOC: {0}", StartLocation.ToString());
-	// Draw box at the starting point of trace
-	DrawDebugBox(
-		Character->GetWorld(),
-		StartLocation,
-		FVector(20.f, 20.f, 20.f),
-		WeaponMesh->GetSocketQuaternion(WeaponTraceEndSocket),
-		FColor::Cyan,
-		false,
-		5.0f
-	);
+	State.WeaponTraceShape = FCollisionShape::MakeBox(WeaponTraceBoxHalfExtent);
+
+	// Sub-steps start from the pose the blade had when the notify began
+	CacheBladeSockets(State, WeaponMesh);
+	State.PreviousBladePose = GetCurrentBladePose(State, WeaponMesh);
+	State.bHasSweptPreviousPose = false;
+}
+
+uint32 UARPGAnimNotifyStateWeaponTrace::MakeClaimSwingId(const ACharacter* Character, const FAnimNotifyEvent* NotifyEvent)
+{
+	// A predicted activation has the same prediction key on the client and the server, which tells apart repeats of the same attack
+	uint32 Hash = 0;
+	UAbilitySystemComponent* AbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Character);
+	if (const UGameplayAbility* AnimatingAbility = AbilitySystem ? AbilitySystem->GetAnimatingAbility() : nullptr)
+	{
+		Hash = GetTypeHash(AnimatingAbility->GetCurrentActivationInfo().GetActivationPredictionKey().Current);
+	}
+
+	// Tells apart the swings of one montage, e.g. the hits of a combo. Object names and pointers differ between machines, timings don't
+	if (NotifyEvent)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent->GetTriggerTime()));
+		Hash = HashCombine(Hash, GetTypeHash(NotifyEvent->GetDuration()));
+	}
+
+	return Hash;
 }
 
 // Repeatedly check for overlaps with enemy characters with a box trace around the character's sword
@@ -94,14 +132,24 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyTick(USkeletalMeshComponent* MeshCom
 	SCOPE_CYCLE_COUNTER(STAT_ARPGAnimNotifyStateWeaponTrace_NotifyTick);
 	Super::NotifyTick(MeshComp, Animation, FrameDeltaTime, EventReference);
 
+	// No state means NotifyBegin decided this mesh doesn't trace (e.g., simulated proxies)
+	UARPGWeaponTraceSubsystem* WeaponTraceSubsystem = UARPGWeaponTraceSubsystem::Get(MeshComp);
+	FARPGWeaponTraceState* State = WeaponTraceSubsystem ? WeaponTraceSubsystem->FindState(MeshComp, EventReference.GetNotify()) : nullptr;
+	if (!State)
+	{
+		return;
+	}
+
+	ACharacter* Character = State->Character.Get();
+	UStaticMeshComponent* WeaponMesh = State->WeaponMesh.Get();
 	if (!Character || !WeaponMesh)
 	{
 		UE_LOG(LogTemp, Error, TEXT("Character or WeaponMesh is null in UARPGAnimNotifyStateWeaponTrace::NotifyTick"));
 		return;
 	}
 
-	// Only proceed if the character has authority or is the autonomous proxy (local player)
-	if (Character->GetLocalRole() != ROLE_Authority && Character->GetLocalRole() != ROLE_AutonomousProxy)
+	// Hits for this swing are claimed by the owning client
+	if (State->bServerValidatesClaims)
 	{
 		return;
 	}
@@ -113,62 +161,108 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyTick(USkeletalMeshComponent* MeshCom
 		return;
 	}
 
-	// Define the start and end locations of the trace
-	FVector StartLocation = WeaponMesh->GetSocketLocation(WeaponTraceStartSocket);
-	FVector EndLocation = WeaponMesh->GetSocketLocation(WeaponTraceEndSocket);
-	FVector MidVec = EndLocation - StartLocation;
-	// get up vector of world
-	FQuat TraceRotation = WeaponMesh->GetSocketQuaternion(WeaponTraceEndSocket);
-
-	UE_LOGFMT(LogTemp, Log, "Start location: {0}, end location: {1}, trace rotation: {2}, end-start: {3}", StartLocation.ToString(), EndLocation.ToString(), TraceRotation.ToString(), MidVec.ToString());
-
-	// Perform the sweep trace
-	TArray<FHitResult> HitResults;
-	bool bHit = World->SweepMultiByObjectType(
-		HitResults,
-		StartLocation,
-		EndLocation,
-		TraceRotation,
-		CollisionObjectQueryParams,
-		WeaponTraceShape,
-		CollisionQueryParams
-	);
-	// Draw path of the trace
-	DrawDebugLine(
-		World,               // The world context
-		StartLocation,       // Starting point of the trace
-		EndLocation,         // Ending point of the trace
-		FColor::Red,         // Line color (Red, for example)
-		false,               // Persistent (false for temporary, true for persistent)
-		2.0f,                // Duration (2 seconds for temporary debug line)
-		0,                   // Depth priority (0 for default)
-		1.0f                 // Line thickness
-	);
-
-
-	// Draw box at the starting point of trace
-	DrawDebugBox(
-		World,
-		StartLocation,
-		FVector(1.f, 1.f, 1.f),
-		TraceRotation,
-		FColor::Yellow,
-		false,
-		2.0f
-	);
-
-	DrawDebugBox(
-		World,
-		EndLocation,
-		FVector(1.f, 1.f, 1.f),
-		TraceRotation,
-		FColor::Yellow,
-		false,
-		2.0f
-	);
-
-	// Process each hit result
-	for (const FHitResult& HitResult : HitResults)
+	// Sweep the blade along its swing path since the last tick
+	SweepBlade(World, *State, GetCurrentBladePose(*State, WeaponMesh));
+
+	// Async sweeps are processed by the weapon trace subsystem next frame
+	if (!State->bAsync)
+	{
+		ProcessHitResults(*State);
+	}
+}
+
+void UARPGAnimNotifyStateWeaponTrace::CacheBladeSockets(FARPGWeaponTraceState& State, const UStaticMeshComponent* WeaponMesh) const
+{
+	State.BladeSocketsMesh = WeaponMesh->GetStaticMesh();
+
+	FTransform StartTransform = FTransform::Identity;
+	if (const UStaticMeshSocket* StartSocket = WeaponMesh->GetSocketByName(WeaponTraceStartSocket))
+	{
+		StartTransform = FTransform(StartSocket->RelativeRotation, StartSocket->RelativeLocation, StartSocket->RelativeScale);
+	}
+
+	FTransform EndTransform = FTransform::Identity;
+	if (const UStaticMeshSocket* EndSocket = WeaponMesh->GetSocketByName(WeaponTraceEndSocket))
+	{
+		EndTransform = FTransform(EndSocket->RelativeRotation, EndSocket->RelativeLocation, EndSocket->RelativeScale);
+	}
+
+	State.LocalBladeStart = StartTransform.GetLocation();
+	State.LocalBladeEnd = EndTransform.GetLocation();
+	State.LocalBladeRotation = EndTransform.GetRotation();
+}
+
+FARPGWeaponBladePose UARPGAnimNotifyStateWeaponTrace::GetCurrentBladePose(FARPGWeaponTraceState& State, const UStaticMeshComponent* WeaponMesh) const
+{
+	if (State.BladeSocketsMesh.Get() != WeaponMesh->GetStaticMesh())
+	{
+		CacheBladeSockets(State, WeaponMesh);
+	}
+
+	// One component transform for both ends instead of resolving each socket by name
+	const FTransform& ComponentTransform = WeaponMesh->GetComponentTransform();
+	return FARPGWeaponBladePose(
+		ComponentTransform.TransformPosition(State.LocalBladeStart),
+		ComponentTransform.TransformPosition(State.LocalBladeEnd),
+		ComponentTransform.GetRotation() * State.LocalBladeRotation);
+}
+
+void UARPGAnimNotifyStateWeaponTrace::SweepBlade(UWorld* World, FARPGWeaponTraceState& State, const FARPGWeaponBladePose& CurrentPose) const
+{
+	// Async hits accumulate in HitResults until the subsystem processes them
+	if (!State.bAsync)
+	{
+		State.HitResults.Reset();
+	}
+
+	// Consecutive poses must overlap, so no point of the blade may move further than the box is thick
+	const float MaxStepDistance = 2.f * FMath::Min(WeaponTraceBoxHalfExtent.X, WeaponTraceBoxHalfExtent.Y);
+	const int32 NumSubsteps = ARPGWeaponTrace::ComputeNumSubsteps(State.PreviousBladePose, CurrentPose, MaxStepDistance, MaxSubstepAngle, MaxSubsteps);
+
+	// The starting pose is only swept once, on the first tick of the swing
+	const int32 FirstStep = State.bHasSweptPreviousPose ? 1 : 0;
+
+	UARPGWeaponTraceSubsystem* WeaponTraceSubsystem = State.bAsync ? UARPGWeaponTraceSubsystem::Get(World) : nullptr;
+
+	TArray<FHitResult>& StepHitResults = State.StepHitResults;
+	for (int32 Step = FirstStep; Step <= NumSubsteps; ++Step)
+	{
+		const FARPGWeaponBladePose Pose = Step == NumSubsteps
+			? CurrentPose
+			: FARPGWeaponBladePose::Interpolate(State.PreviousBladePose, CurrentPose, static_cast<float>(Step) / NumSubsteps);
+
+		ARPG_WEAPON_TRACE_DEBUG_SWEEP(World, Pose, State.WeaponTraceShape);
+
+		if (WeaponTraceSubsystem)
+		{
+			WeaponTraceSubsystem->RequestAsyncSweep(World, State, Pose);
+			continue;
+		}
+
+		StepHitResults.Reset();
+		World->SweepMultiByObjectType(
+			StepHitResults,
+			Pose.Start,
+			Pose.End,
+			Pose.Rotation,
+			State.CollisionObjectQueryParams,
+			State.WeaponTraceShape,
+			State.CollisionQueryParams
+		);
+
+		State.HitResults.Append(StepHitResults);
+	}
+
+	State.PreviousBladePose = CurrentPose;
+	State.bHasSweptPreviousPose = true;
+}
+
+void UARPGAnimNotifyStateWeaponTrace::ProcessHitResults(FARPGWeaponTraceState& State) const
+{
+	// Hits from consecutive sub-steps overlap, only consider each actor once per sweep
+	TArray<FARPGWeaponTraceHitCandidate, TInlineAllocator<8>> Candidates;
+
+	for (const FHitResult& HitResult : State.HitResults)
 	{
 
 		AActor* HitActor = HitResult.GetActor();
@@ -177,58 +271,121 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyTick(USkeletalMeshComponent* MeshCom
 			continue;
 		}
 
-		// Check if the hit actor is another character
-		if (AARPGCharacter* HitCharacter = Cast<AARPGCharacter>(HitActor))
+		if (Candidates.ContainsByPredicate([HitActor](const FARPGWeaponTraceHitCandidate& Candidate) { return Candidate.Actor == HitActor; }))
 		{
+			continue;
+		}
 
-			DebugDrawBoxAroundCharacter(HitCharacter, FColor::Green, 0.3f);
+		// Only actors with an ability system component can be hit (player characters and enemies)
+		UAbilitySystemComponent* HitASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(HitActor);
+		if (!HitASC)
+		{
+			continue;
+		}
 
-			// If the hit character has an ability system component, trigger the OnWeaponTraceHitActor event
-			if (Cast<UARPGAbilitySystemComponent>(HitCharacter->GetAbilitySystemComponent()))
-			{
+		FARPGWeaponTraceHitCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+		Candidate.Actor = HitActor;
+		Candidate.AbilitySystem = HitASC;
+		Candidate.BladeStart = HitResult.TraceStart;
+		Candidate.BladeEnd = HitResult.TraceEnd;
+	}
 
-				// If we should NOT hit the same actor multiple times and this actor hasn't been hit yet
-				if (!bHitSameActorMultipleTimes && !AlreadyHitActors.Contains(HitCharacter))
-				{
-					AlreadyHitActors.Add(HitCharacter);
-					CollisionQueryParams.AddIgnoredActor(HitCharacter);
-					OnWeaponTraceHitActor(Character, HitCharacter);
-				}
-				else if (bHitSameActorMultipleTimes)
-				{
-					OnWeaponTraceHitActor(Character, HitCharacter);
-				}
+	ProcessHitCandidates(State, Candidates);
+}
 
-			}
+void UARPGAnimNotifyStateWeaponTrace::ProcessHitCandidates(FARPGWeaponTraceState& State, TConstArrayView<FARPGWeaponTraceHitCandidate> Candidates) const
+{
+	ACharacter* Character = State.Character.Get();
+	if (!Character || Candidates.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FARPGWeaponTraceHitCandidate, TInlineAllocator<8>> AcceptedHits;
+	const double Now = Character->GetWorld()->GetTimeSeconds();
+	const uint32 SwingId = State.SwingId;
+
+	for (const FARPGWeaponTraceHitCandidate& Candidate : Candidates)
+	{
+		ARPG_WEAPON_TRACE_DEBUG_HIT(Candidate.Actor->GetWorld(), Candidate.Actor);
+
+		if (TryRecordHit(State, Candidate.Actor, Now))
+		{
+			AcceptedHits.Add(Candidate);
+		}
+	}
+
+	// The owning client only predicts its hits, the server decides whether they count
+	if (AcceptedHits.Num() > 0 && !Character->HasAuthority())
+	{
+		const UWorld* World = Character->GetWorld();
+		const AGameStateBase* GameState = World->GetGameState();
+		const float ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+		TArray<FARPGWeaponHitClaim> Claims;
+		Claims.Reserve(AcceptedHits.Num());
+		for (const FARPGWeaponTraceHitCandidate& Hit : AcceptedHits)
+		{
+			FARPGWeaponHitClaim& Claim = Claims.AddDefaulted_GetRef();
+			Claim.SwingId = State.ClaimSwingId;
+			Claim.Target = Hit.Actor;
+			Claim.ServerTime = ServerTime;
+			Claim.BladeStart = Hit.BladeStart;
+			Claim.BladeEnd = Hit.BladeEnd;
 		}
+
+		// Only player characters are locally controlled on clients
+		if (AARPGCharacter* PlayerCharacter = Cast<AARPGCharacter>(Character))
+		{
+			PlayerCharacter->ServerSubmitWeaponHitClaims(Claims);
+		}
+	}
+
+	// Hit events run Blueprint code which may end this swing and recycle its state, so don't touch the state past this point
+	for (const FARPGWeaponTraceHitCandidate& Hit : AcceptedHits)
+	{
+		HandleHit(Character, Hit.Actor, Hit.AbilitySystem, SwingId);
 	}
 }
 
-void UARPGAnimNotifyStateWeaponTrace::DebugDrawBoxAroundCharacter(ACharacter* TargetCharacter, FColor Color, float Duration)
+bool UARPGAnimNotifyStateWeaponTrace::TryRecordHit(FARPGWeaponTraceState& State, const AActor* HitActor, double Time) const
 {
-	if (!TargetCharacter)
+	const TObjectKey<AActor> ActorKey(HitActor);
+	FARPGWeaponTraceHitRecord* Record = State.HitRecords.FindByPredicate([&ActorKey](const FARPGWeaponTraceHitRecord& Existing) { return Existing.Actor == ActorKey; });
+	if (!Record)
 	{
-		return;
+		Record = &State.HitRecords.AddDefaulted_GetRef();
+		Record->Actor = ActorKey;
 	}
-	UWorld* World = TargetCharacter->GetWorld();
-	if (!World)
+	else if (!bHitSameActorMultipleTimes
+		|| (MaxHitsPerTarget > 0 && Record->NumHits >= MaxHitsPerTarget)
+		|| Time - Record->LastHitTime < MultiHitInterval)
 	{
+		return false;
+	}
+
+	++Record->NumHits;
+	Record->LastHitTime = Time;
+	return true;
+}
+
+void UARPGAnimNotifyStateWeaponTrace::HandleHit(ACharacter* Character, AActor* HitActor, UAbilitySystemComponent* HitASC, uint32 SwingId) const
+{
+	if (!Character->HasAuthority())
+	{
+		OnWeaponTracePredictedHit(Character, HitActor);
 		return;
 	}
-	DrawDebugBox(
-		World,
-		TargetCharacter->GetActorLocation(),
-		FVector(
-			TargetCharacter->GetCapsuleComponent()->GetScaledCapsuleRadius(),
-			TargetCharacter->GetCapsuleComponent()->GetScaledCapsuleRadius(),
-			TargetCharacter->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()
-		),
-		Color,
-		false,
-		Duration,
-		0,
-		1.0f
-	);
+
+	OnWeaponTraceHitActor(Character, HitActor);
+
+	if (BaseDamage > 0.f)
+	{
+		if (UARPGDamageBatchSubsystem* DamageBatcher = UARPGDamageBatchSubsystem::Get(Character))
+		{
+			DamageBatcher->QueueDamageToAbilitySystem(HitASC, BaseDamage, Character, SwingId);
+		}
+	}
 }
 
 void UARPGAnimNotifyStateWeaponTrace::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
@@ -236,24 +393,33 @@ void UARPGAnimNotifyStateWeaponTrace::NotifyEnd(USkeletalMeshComponent* MeshComp
 	SCOPE_CYCLE_COUNTER(STAT_ARPGAnimNotifyStateWeaponTrace_NotifyEnd);
 	Super::NotifyEnd(MeshComp, Animation, EventReference);
 
-	if (WeaponMesh)
+	UARPGWeaponTraceSubsystem* WeaponTraceSubsystem = UARPGWeaponTraceSubsystem::Get(MeshComp);
+	FARPGWeaponTraceState* State = WeaponTraceSubsystem ? WeaponTraceSubsystem->FindState(MeshComp, EventReference.GetNotify()) : nullptr;
+	if (!State)
 	{
-		FVector StartLocation = WeaponMesh->GetSocketLocation(WeaponTraceStartSocket);
-		UE_LOGFMT(LogTemp, Log, "END LOC: {0}", StartLocation.ToString());
-
-		DrawDebugBox(
-			Character->GetWorld(),
-			StartLocation,
-			FVector(20.f, 20.f, 20.f),
-			WeaponMesh->GetSocketQuaternion(WeaponTraceEndSocket),
-			FColor::Purple,
-			1,
-			5.0f
-		);
+		return;
+	}
+
+	ACharacter* Character = State->Character.Get();
+	UStaticMeshComponent* WeaponMesh = State->WeaponMesh.Get();
+
+	// Sweep the last part of the swing, between the final tick and the end of the notify, so the covered
+	// swing doesn't depend on where the frame boundaries fell
+	if (Character && WeaponMesh && State->bHasSweptPreviousPose && !State->bServerValidatesClaims)
+	{
+		if (UWorld* World = Character->GetWorld())
+		{
+			SweepBlade(World, *State, GetCurrentBladePose(*State, WeaponMesh));
+			if (!State->bAsync)
+			{
+				ProcessHitResults(*State);
+			}
+		}
 	}
 
-	// Clear references to ensure they are not used after the notify ends (notify states seem to retain state/be reused across multiple executions?)
-	Character = nullptr;
-	WeaponMesh = nullptr;
-	AlreadyHitActors.Empty();
+	// Hand the state back to the pool. The notify object itself never holds swing state.
+	// With async sweeps, the state stays alive until the hits of its last sweeps have been processed.
+	// Swings validating client claims stay alive a little longer, since the client's last claims are still in flight.
+	const float ReleaseDelay = State->bServerValidatesClaims ? UARPGWeaponTraceSubsystem::GetClaimGraceSeconds() : 0.f;
+	WeaponTraceSubsystem->ReleaseState(MeshComp, EventReference.GetNotify(), ReleaseDelay);
 }
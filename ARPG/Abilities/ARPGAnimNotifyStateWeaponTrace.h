@@ -4,10 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimNotifies/AnimNotifyState.h"
-#include "ARPG/Core/ARPGCharacter.h"
+#include "ARPGWeaponTraceTypes.h"
+#include "ARPGWeaponTraceSubsystem.h"
 #include "ARPGAnimNotifyStateWeaponTrace.generated.h"
 
-DECLARE_STATS_GROUP(TEXT("ARPGAnimNotifications"), STATGROUP_ARPGAnimNotifications, STATCAT_Advanced);
+class ACharacter;
+struct FAnimNotifyEvent;
 
 DECLARE_CYCLE_STAT(TEXT("Weapon Trace Notify Tick"), STAT_ARPGAnimNotifyStateWeaponTrace_NotifyTick, STATGROUP_ARPGAnimNotifications);
 DECLARE_CYCLE_STAT(TEXT("Weapon Trace Notify Begin"), STAT_ARPGAnimNotifyStateWeaponTrace_NotifyBegin, STATGROUP_ARPGAnimNotifications);
@@ -16,7 +18,15 @@ DECLARE_CYCLE_STAT(TEXT("Weapon Trace Notify End"), STAT_ARPGAnimNotifyStateWeap
  * During an animation montage, this notify state will perform a box trace from the weapon mesh's 
  * start socket to the end socket.
  * 
- * The trace will occur every single tick.
+ * Every tick, the blade is swept at several poses interpolated between its previous and current pose,
+ * so fast swings and low frame rates don't skip over targets.
+ *
+ * Notify objects are shared by every mesh playing the animation, so the state of each swing is kept
+ * in UARPGWeaponTraceSubsystem instead of on the notify.
+ *
+ * Characters controlled by a remote client are traced on that client only. The client predicts its hits
+ * and sends them to the server as claims, and the server validates the claims instead of sweeping itself.
+ * Only hits confirmed by the server fire OnWeaponTraceHitActor and deal damage.
  */
 UCLASS()
 class ARPG_API UARPGAnimNotifyStateWeaponTrace : public UAnimNotifyState
@@ -62,18 +72,67 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Trace")
 	bool bIgnoreSelf = true;
 
+	/**
+	 * @brief The maximum angle (in degrees) the blade may rotate between two swept poses.
+	 *	Faster swings are split into more sub-steps.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Trace", meta = (ClampMin = 1, UIMin = 1, UIMax = 45))
+	float MaxSubstepAngle = 10.f;
+
+	/**
+	 * @brief Upper bound of poses swept per tick, regardless of how far the blade moved.
+	 *	Hits are only frame-rate independent while a tick needs fewer sub-steps than this, i.e. while the blade
+	 *	rotates less than MaxSubstepAngle * MaxSubsteps and moves less than MaxSubsteps times the trace box
+	 *	thickness per tick. With the defaults that's 160 degrees per tick: a 180 degree swing lasting 0.3 seconds
+	 *	(600 degrees per second) gives the same hits down to 4 fps, and starts skipping targets below that.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Trace", meta = (ClampMin = 1, UIMin = 1, UIMax = 32))
+	int32 MaxSubsteps = 16;
+
 
 	/**
 	 * @brief If true, then a single swing can trigger multiple hits on the same actor in a single swing
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Melee")
 	bool bHitSameActorMultipleTimes = false;
-	
+
+	/**
+	 * @brief Minimum time (in seconds) between two hits of the same swing on the same actor.
+	 *	0 allows a hit every tick the blade touches the actor.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Melee", meta = (ClampMin = 0, EditCondition = "bHitSameActorMultipleTimes"))
+	float MultiHitInterval = 0.f;
+
+	/**
+	 * @brief Maximum number of hits of the same swing on the same actor. 0 means no limit.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Melee", meta = (ClampMin = 0, EditCondition = "bHitSameActorMultipleTimes"))
+	int32 MaxHitsPerTarget = 0;
+
+	/**
+	 * @brief Damage queued against every actor hit by the trace (server only).
+	 *	Hits are sent to the damage batcher and applied at the end of the frame. Set to 0 to only fire OnWeaponTraceHitActor.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Melee", meta = (ClampMin = 0))
+	float BaseDamage = 0.f;
+
+	/**
+	 * @brief Filters the hits of the last sweep down to hittable actors and calls HandleHit for each of them.
+	 *	Called by UARPGWeaponTraceSubsystem for swings using async sweeps.
+	 */
+	void ProcessHitResults(FARPGWeaponTraceState& State) const;
+
+	/**
+	 * @brief Applies the per-swing hit rules to the given candidates and handles the accepted hits.
+	 *	On the owning client, accepted hits are also sent to the server as hit claims.
+	 */
+	void ProcessHitCandidates(FARPGWeaponTraceState& State, TConstArrayView<FARPGWeaponTraceHitCandidate> Candidates) const;
 
 protected:
+	friend class FARPGWeaponTraceFrameRateTest;
 
 	/**
-	 * @brief Blueprint implementable event that is called when the weapon trace hits an actor
+	 * @brief Blueprint implementable event that is called when the weapon trace hits an actor. Server only.
 	 * @param InstigatorActor The actor that initiated the trace (the character doing the melee attack)
 	 * @param HitActor The actor that was hit by the trace
 	 */
@@ -81,38 +140,48 @@ protected:
 	void OnWeaponTraceHitActor(AActor* InstigatorActor, AActor* HitActor) const;
 
 	/**
-	 * @brief Draws a box around a character for debugging purposes.
+	 * @brief Blueprint implementable event that is called on the owning client when its trace hits an actor.
+	 *	The hit is only a prediction, use it for cosmetics. The server may still reject it.
+	 * @param InstigatorActor The actor that initiated the trace (the character doing the melee attack)
+	 * @param HitActor The actor that was hit by the trace
 	 */
-	UFUNCTION()
-	void DebugDrawBoxAroundCharacter(ACharacter* TargetCharacter, FColor Color, float Duration);
-private:
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon Trace")
+	void OnWeaponTracePredictedHit(AActor* InstigatorActor, AActor* HitActor) const;
+
 	/**
-	 * @brief The character executing the animation montage
+	 * @brief Builds the id the owning client and the server both give a swing, so hit claims are validated against the right swing.
+	 *	Combines the prediction key of the ability playing the montage with the notify's trigger time and duration.
 	 */
-	TObjectPtr<AARPGCharacter> Character;
+	static uint32 MakeClaimSwingId(const ACharacter* Character, const FAnimNotifyEvent* NotifyEvent);
 
 	/**
-	 * @brief The weapon mesh of the character
+	 * @brief Records a hit on the actor if the swing's hit rules allow it.
+	 *	Without bHitSameActorMultipleTimes an actor is hit once per swing, otherwise MultiHitInterval and MaxHitsPerTarget apply.
+	 * @return True if the hit counts
 	 */
-	TObjectPtr<UStaticMeshComponent> WeaponMesh;
+	bool TryRecordHit(FARPGWeaponTraceState& State, const AActor* HitActor, double Time) const;
 
 	/**
-	 * @brief Struct that contains list of object types the trace will look for when performing a collision query
-	 *	Created using the ObjectTypesToQuery array.
+	 * @brief Called for every accepted hit. On the server, fires OnWeaponTraceHitActor and queues BaseDamage.
+	 *	On the owning client, fires OnWeaponTracePredictedHit.
+	 * @param SwingId Id of the swing the hit belongs to. The damage batcher counts one hit per swing and target each frame.
 	 */
-	FCollisionObjectQueryParams CollisionObjectQueryParams;
+	void HandleHit(ACharacter* Character, AActor* HitActor, UAbilitySystemComponent* HitASC, uint32 SwingId) const;
 
 	/**
-	 * @brief Further parameters for the collision query, such as ignored actors
+	 * @brief Resolves the trace sockets on the weapon mesh and stores their offsets from the mesh component in the state.
+	 *	Missing sockets resolve to the component's origin, like GetSocketLocation does.
 	 */
-	FCollisionQueryParams CollisionQueryParams;
+	void CacheBladeSockets(FARPGWeaponTraceState& State, const UStaticMeshComponent* WeaponMesh) const;
 
 	/**
-	 * @brief The shape of the trace that will be performed
+	 * @brief Returns the current world space pose of the blade, from the cached socket offsets and the weapon's component transform
 	 */
-	FCollisionShape WeaponTraceShape;
+	FARPGWeaponBladePose GetCurrentBladePose(FARPGWeaponTraceState& State, const UStaticMeshComponent* WeaponMesh) const;
 
-
-	// Set used to store actors that have already been hit by the trace
-	TSet<AActor*> AlreadyHitActors;
+	/**
+	 * @brief Sweeps the blade at every sub-step between the previous and current pose.
+	 *	Synchronous sweeps store their hits in State.HitResults, async sweeps deliver them to the subsystem next frame.
+	 */
+	void SweepBlade(UWorld* World, FARPGWeaponTraceState& State, const FARPGWeaponBladePose& CurrentPose) const;
 };
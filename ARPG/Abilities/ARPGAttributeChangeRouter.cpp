@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGAttributeChangeRouter.h"
+#include "AbilitySystemComponent.h"
+#include "ARPGHealthAttributeSet.h"
+#include "Engine/World.h"
+
+UARPGAttributeChangeRouter* UARPGAttributeChangeRouter::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGAttributeChangeRouter>() : nullptr;
+}
+
+TConstArrayView<FGameplayAttribute> UARPGAttributeChangeRouter::GetRoutedAttributes()
+{
+	// Add attributes here to make them available to listeners, at most 32
+	static const TArray<FGameplayAttribute> RoutedAttributes =
+	{
+		UARPGHealthAttributeSet::GetHealthAttribute(),
+		UARPGHealthAttributeSet::GetHealthMaxAttribute(),
+	};
+	return RoutedAttributes;
+}
+
+void UARPGAttributeChangeRouter::Deinitialize()
+{
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		if (Slots[SlotIndex].Listeners.Num() > 0)
+		{
+			ReleaseSlot(SlotIndex);
+		}
+	}
+	Slots.Empty();
+	FreeSlots.Empty();
+	SlotIndices.Empty();
+	DirtySlots.Empty();
+
+	Super::Deinitialize();
+}
+
+FDelegateHandle UARPGAttributeChangeRouter::AddListener(UAbilitySystemComponent* AbilitySystem, TConstArrayView<FGameplayAttribute> Attributes, EARPGAttributeChangeDispatch Dispatch, FARPGAttributeChangeListener&& Listener)
+{
+	if (!AbilitySystem || !Listener.IsBound())
+	{
+		return FDelegateHandle();
+	}
+
+	const TConstArrayView<FGameplayAttribute> RoutedAttributes = GetRoutedAttributes();
+
+	uint32 AttributeMask = 0;
+	for (const FGameplayAttribute& Attribute : Attributes)
+	{
+		const int32 AttributeIndex = RoutedAttributes.IndexOfByKey(Attribute);
+		if (!ensureMsgf(AttributeIndex != INDEX_NONE, TEXT("Attribute %s isn't routed, add it to UARPGAttributeChangeRouter::GetRoutedAttributes"), *Attribute.GetName()))
+		{
+			continue;
+		}
+		AttributeMask |= 1u << AttributeIndex;
+	}
+
+	int32 SlotIndex = INDEX_NONE;
+	if (const int32* ExistingSlotIndex = SlotIndices.Find(AbilitySystem))
+	{
+		SlotIndex = *ExistingSlotIndex;
+	}
+	else
+	{
+		SlotIndex = FreeSlots.Num() > 0 ? FreeSlots.Pop(EAllowShrinking::No) : Slots.AddDefaulted();
+		SlotIndices.Add(AbilitySystem, SlotIndex);
+
+		FSlot& NewSlot = Slots[SlotIndex];
+		NewSlot.AbilitySystem = AbilitySystem;
+		NewSlot.AbilitySystemKey = AbilitySystem;
+
+		// The only bindings to the ASC, shared by every listener
+		for (int32 AttributeIndex = 0; AttributeIndex < RoutedAttributes.Num(); ++AttributeIndex)
+		{
+			NewSlot.AttributeHandles.Add(AbilitySystem->GetGameplayAttributeValueChangeDelegate(RoutedAttributes[AttributeIndex])
+				.AddUObject(this, &ThisClass::OnAttributeValueChanged, SlotIndex, AttributeIndex));
+		}
+
+		INC_DWORD_STAT(STAT_ARPGAttributeRouter_AbilitySystems);
+	}
+
+	FSlot& Slot = Slots[SlotIndex];
+	const FDelegateHandle Handle = Listener.GetHandle();
+
+	FListener& NewListener = Slot.Listeners.AddDefaulted_GetRef();
+	NewListener.Delegate = MoveTemp(Listener);
+	NewListener.AttributeMask = AttributeMask;
+	NewListener.Dispatch = Dispatch;
+
+	if (Dispatch == EARPGAttributeChangeDispatch::Coalesced)
+	{
+		Slot.CoalescedMask |= AttributeMask;
+	}
+
+	return Handle;
+}
+
+void UARPGAttributeChangeRouter::RemoveListener(UAbilitySystemComponent* AbilitySystem, FDelegateHandle Handle)
+{
+	const int32* SlotIndex = SlotIndices.Find(AbilitySystem);
+	if (!SlotIndex || !Handle.IsValid())
+	{
+		return;
+	}
+
+	FSlot& Slot = Slots[*SlotIndex];
+	Slot.Listeners.RemoveAll([Handle](const FListener& Listener) { return Listener.Delegate.GetHandle() == Handle; });
+
+	if (Slot.Listeners.Num() == 0)
+	{
+		ReleaseSlot(*SlotIndex);
+		return;
+	}
+
+	Slot.CoalescedMask = 0;
+	for (const FListener& Listener : Slot.Listeners)
+	{
+		if (Listener.Dispatch == EARPGAttributeChangeDispatch::Coalesced)
+		{
+			Slot.CoalescedMask |= Listener.AttributeMask;
+		}
+	}
+}
+
+void UARPGAttributeChangeRouter::ReleaseSlot(int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+
+	if (UAbilitySystemComponent* AbilitySystem = Slot.AbilitySystem.Get())
+	{
+		const TConstArrayView<FGameplayAttribute> RoutedAttributes = GetRoutedAttributes();
+		for (int32 AttributeIndex = 0; AttributeIndex < Slot.AttributeHandles.Num(); ++AttributeIndex)
+		{
+			AbilitySystem->GetGameplayAttributeValueChangeDelegate(RoutedAttributes[AttributeIndex]).Remove(Slot.AttributeHandles[AttributeIndex]);
+		}
+	}
+
+	SlotIndices.Remove(Slot.AbilitySystemKey);
+	Slot = FSlot();
+	FreeSlots.Add(SlotIndex);
+
+	DEC_DWORD_STAT(STAT_ARPGAttributeRouter_AbilitySystems);
+}
+
+void UARPGAttributeChangeRouter::OnAttributeValueChanged(const FOnAttributeChangeData& Data, int32 SlotIndex, int32 AttributeIndex)
+{
+	++ChangesInWindow;
+	INC_DWORD_STAT(STAT_ARPGAttributeRouter_Changes);
+
+	const uint32 AttributeBit = 1u << AttributeIndex;
+
+	FARPGAttributeChange Change;
+	Change.Attribute = Data.Attribute;
+	Change.OldValue = Data.OldValue;
+	Change.NewValue = Data.NewValue;
+
+	// Listeners may add or remove listeners, index the arrays again after every call
+	for (int32 ListenerIndex = 0; ListenerIndex < Slots[SlotIndex].Listeners.Num(); ++ListenerIndex)
+	{
+		const FListener& Listener = Slots[SlotIndex].Listeners[ListenerIndex];
+		if (Listener.Dispatch == EARPGAttributeChangeDispatch::Immediate && (Listener.AttributeMask & AttributeBit))
+		{
+			++ListenerCallsInWindow;
+			INC_DWORD_STAT(STAT_ARPGAttributeRouter_ListenerCalls);
+			Listener.Delegate.ExecuteIfBound(Change);
+		}
+	}
+
+	if (!Slots.IsValidIndex(SlotIndex) || !(Slots[SlotIndex].CoalescedMask & AttributeBit))
+	{
+		return;
+	}
+
+	FSlot& Slot = Slots[SlotIndex];
+	if (FARPGAttributeChange* PendingChange = Slot.PendingChanges.FindByPredicate([&Change](const FARPGAttributeChange& Pending) { return Pending.Attribute == Change.Attribute; }))
+	{
+		PendingChange->NewValue = Change.NewValue;
+		++PendingChange->NumChanges;
+	}
+	else
+	{
+		if (Slot.PendingChanges.Num() == 0)
+		{
+			DirtySlots.Add(SlotIndex);
+		}
+		Slot.PendingChanges.Add(Change);
+	}
+}
+
+void UARPGAttributeChangeRouter::FlushPendingChanges()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGAttributeRouter_Flush);
+
+	const TConstArrayView<FGameplayAttribute> RoutedAttributes = GetRoutedAttributes();
+
+	// Listeners may change attributes again, those changes go out with the next flush
+	const TArray<int32> SlotsToFlush = MoveTemp(DirtySlots);
+	DirtySlots.Reset();
+
+	for (const int32 SlotIndex : SlotsToFlush)
+	{
+		if (!Slots[SlotIndex].AbilitySystem.IsValid())
+		{
+			Slots[SlotIndex].PendingChanges.Reset();
+			continue;
+		}
+
+		const TArray<FARPGAttributeChange, TInlineAllocator<2>> Changes = MoveTemp(Slots[SlotIndex].PendingChanges);
+		Slots[SlotIndex].PendingChanges.Reset();
+
+		for (const FARPGAttributeChange& Change : Changes)
+		{
+			const uint32 AttributeBit = 1u << RoutedAttributes.IndexOfByKey(Change.Attribute);
+
+			for (int32 ListenerIndex = 0; ListenerIndex < Slots[SlotIndex].Listeners.Num(); ++ListenerIndex)
+			{
+				const FListener& Listener = Slots[SlotIndex].Listeners[ListenerIndex];
+				if (Listener.Dispatch == EARPGAttributeChangeDispatch::Coalesced && (Listener.AttributeMask & AttributeBit))
+				{
+					++ListenerCallsInWindow;
+					INC_DWORD_STAT(STAT_ARPGAttributeRouter_ListenerCalls);
+					Listener.Delegate.ExecuteIfBound(Change);
+				}
+			}
+		}
+	}
+}
+
+void UARPGAttributeChangeRouter::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushPendingChanges();
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now - StatsWindowStart >= 1.0)
+	{
+		const double WindowSeconds = Now - StatsWindowStart;
+		Stats.ChangesPerSecond = FMath::RoundToInt(ChangesInWindow / WindowSeconds);
+		Stats.ListenerCallsPerSecond = FMath::RoundToInt(ListenerCallsInWindow / WindowSeconds);
+		Stats.NumAbilitySystems = SlotIndices.Num();
+		ChangesInWindow = 0;
+		ListenerCallsInWindow = 0;
+		StatsWindowStart = Now;
+
+		// Free the slots of ASCs destroyed without removing their listeners
+		for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+		{
+			if (Slots[SlotIndex].Listeners.Num() > 0 && !Slots[SlotIndex].AbilitySystem.IsValid())
+			{
+				ReleaseSlot(SlotIndex);
+			}
+		}
+	}
+}
+
+TStatId UARPGAttributeChangeRouter::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGAttributeChangeRouter, STATGROUP_Tickables);
+}
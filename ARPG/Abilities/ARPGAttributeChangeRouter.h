@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "AttributeSet.h"
+#include "ARPGAttributeChangeRouter.generated.h"
+
+class UAbilitySystemComponent;
+struct FOnAttributeChangeData;
+
+DECLARE_STATS_GROUP(TEXT("ARPGAttributes"), STATGROUP_ARPGAttributes, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Attribute Change Flush"), STAT_ARPGAttributeRouter_Flush, STATGROUP_ARPGAttributes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attribute Changes"), STAT_ARPGAttributeRouter_Changes, STATGROUP_ARPGAttributes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attribute Listener Calls"), STAT_ARPGAttributeRouter_ListenerCalls, STATGROUP_ARPGAttributes);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Routed Ability Systems"), STAT_ARPGAttributeRouter_AbilitySystems, STATGROUP_ARPGAttributes);
+
+/** A change of an attribute, possibly several changes of the same frame combined */
+struct FARPGAttributeChange
+{
+	FGameplayAttribute Attribute;
+
+	/** Value before the first change */
+	float OldValue = 0.f;
+
+	/** Value after the last change */
+	float NewValue = 0.f;
+
+	/** Number of changes combined into this one */
+	int32 NumChanges = 1;
+};
+
+DECLARE_DELEGATE_OneParam(FARPGAttributeChangeListener, const FARPGAttributeChange& /*Change*/);
+
+/** When a listener is called */
+enum class EARPGAttributeChangeDispatch : uint8
+{
+	/** On every change, as it happens */
+	Immediate,
+	/** Once per frame and attribute, with every change of the frame combined */
+	Coalesced
+};
+
+/**
+ * Stats about attribute changes over the last second. Exposed so they can be shown in debug UI.
+ */
+USTRUCT(BlueprintType)
+struct FARPGAttributeChangeRouterStats
+{
+	GENERATED_BODY()
+
+	// Attribute changes reported by ability systems per second
+	UPROPERTY(BlueprintReadOnly, Category = "Attributes")
+	int32 ChangesPerSecond = 0;
+
+	// Listener calls per second, after coalescing
+	UPROPERTY(BlueprintReadOnly, Category = "Attributes")
+	int32 ListenerCallsPerSecond = 0;
+
+	// Ability systems with at least one listener
+	UPROPERTY(BlueprintReadOnly, Category = "Attributes")
+	int32 NumAbilitySystems = 0;
+};
+
+/**
+ * Central dispatcher of attribute changes.
+ *
+ * Instead of every actor binding its own handlers to its ASC's attribute delegates, listeners register with the
+ * router for a set of attributes. The router binds to an ASC once per routed attribute and dispatches through a
+ * compact table with one slot per ASC, each listener being called only for the attributes it asked for.
+ * Coalesced listeners get at most one call per attribute and frame.
+ *
+ * Only the attributes returned by GetRoutedAttributes can be listened to.
+ */
+UCLASS()
+class ARPG_API UARPGAttributeChangeRouter : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the attribute change router of the world the context object lives in */
+	static UARPGAttributeChangeRouter* Get(const UObject* WorldContextObject);
+
+	/** Attributes that can be listened to */
+	static TConstArrayView<FGameplayAttribute> GetRoutedAttributes();
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Calls the listener when one of the attributes of the ASC changes.
+	 *
+	 * @param AbilitySystem ASC owning the attributes
+	 * @param Attributes Attributes to listen to, must be routed attributes
+	 * @param Dispatch Whether the listener is called on every change or once per frame
+	 * @param Listener Listener to call
+	 * @return Handle to remove the listener with
+	 */
+	FDelegateHandle AddListener(UAbilitySystemComponent* AbilitySystem, TConstArrayView<FGameplayAttribute> Attributes, EARPGAttributeChangeDispatch Dispatch, FARPGAttributeChangeListener&& Listener);
+
+	void RemoveListener(UAbilitySystemComponent* AbilitySystem, FDelegateHandle Handle);
+
+	UFUNCTION(BlueprintCallable, Category = "Attributes|Debug")
+	const FARPGAttributeChangeRouterStats& GetStats() const { return Stats; }
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	struct FListener
+	{
+		FARPGAttributeChangeListener Delegate;
+
+		// Bit N set if the listener wants RoutedAttributes[N]
+		uint32 AttributeMask = 0;
+
+		EARPGAttributeChangeDispatch Dispatch = EARPGAttributeChangeDispatch::Immediate;
+	};
+
+	struct FSlot
+	{
+		TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem;
+
+		TObjectKey<UAbilitySystemComponent> AbilitySystemKey;
+
+		TArray<FListener, TInlineAllocator<2>> Listeners;
+
+		// Handles of our bindings to the ASC, one per routed attribute
+		TArray<FDelegateHandle, TInlineAllocator<4>> AttributeHandles;
+
+		// Changes waiting for the coalesced listeners, at most one per attribute
+		TArray<FARPGAttributeChange, TInlineAllocator<2>> PendingChanges;
+
+		// Union of the masks of the coalesced listeners
+		uint32 CoalescedMask = 0;
+	};
+
+	void OnAttributeValueChanged(const FOnAttributeChangeData& Data, int32 SlotIndex, int32 AttributeIndex);
+
+	/** Unbinds from the ASC and frees the slot */
+	void ReleaseSlot(int32 SlotIndex);
+
+	/** Calls the coalesced listeners with the changes of the frame */
+	void FlushPendingChanges();
+
+	/** One slot per ASC with listeners. Slots are reused, so indices stay valid while bound. */
+	TArray<FSlot> Slots;
+
+	TArray<int32> FreeSlots;
+
+	TMap<TObjectKey<UAbilitySystemComponent>, int32> SlotIndices;
+
+	/** Slots with pending changes */
+	TArray<int32> DirtySlots;
+
+	int32 ChangesInWindow = 0;
+	int32 ListenerCallsInWindow = 0;
+	double StatsWindowStart = 0.0;
+
+	FARPGAttributeChangeRouterStats Stats;
+};
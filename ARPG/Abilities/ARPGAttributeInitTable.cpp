@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGAttributeInitTable.h"
+#include "ARPGAbilitySet.h"
+#include "ARPGAbilitySystemComponent.h"
+#include "ARPGAttributeSet.h"
+#include "Logging/StructuredLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("Attribute Init Table Apply"), STAT_ARPGAttributeInitTable_Apply, STATGROUP_ARPGAbilities);
+
+bool UARPGAttributeInitTable::ApplyToAbilitySystem(UARPGAbilitySystemComponent* ASC, FName ArchetypeName, int32 Level) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGAttributeInitTable_Apply);
+
+	if (!ASC)
+	{
+		UE_LOGFMT(LogTemp, Log, "Tried to apply attribute init table {0}, but the provided ASC was null.", GetName());
+		return false;
+	}
+
+	const FResolvedArchetype* Resolved = ResolveArchetype(ArchetypeName, Level);
+	if (!Resolved)
+	{
+		UE_LOGFMT(LogTemp, Warning, "Attribute init table {0} has no archetype named {1}.", GetName(), ArchetypeName);
+		return false;
+	}
+
+	// Once an effect is active its aggregators hold the attribute values, writing around them would desync them
+	// and skip clamping. Fall back to the full path in that case.
+	const bool bCompact = ASC->UsesCompactAttributeStorage() && ASC->GetActiveGameplayEffects().GetNumGameplayEffects() == 0;
+	if (ASC->UsesCompactAttributeStorage() && !bCompact)
+	{
+		UE_LOGFMT(LogTemp, Warning, "Attribute init table {0} applied after gameplay effects, using the full path. Initialize attributes before granting effects.", GetName());
+	}
+	TArray<UARPGAttributeSet*, TInlineAllocator<4>> DirectlyInitializedSets;
+
+	for (int32 Index = 0; Index < Resolved->Attributes.Num(); ++Index)
+	{
+		const FGameplayAttribute& Attribute = Resolved->Attributes[Index];
+		float Value = Resolved->Values[Index];
+
+		if (!bCompact)
+		{
+			// Full path: goes through the active effects container so aggregators and change delegates stay in sync
+			ASC->SetNumericAttributeBase(Attribute, Value);
+			continue;
+		}
+
+		// Compact path: nothing has modified the attribute yet, so there is no aggregator to keep in sync.
+		// Write the base and current values directly and skip all the change bookkeeping.
+		UAttributeSet* Set = const_cast<UAttributeSet*>(ASC->GetAttributeSet(Attribute.GetAttributeSetClass()));
+		if (!Set)
+		{
+			UE_LOGFMT(LogTemp, Warning, "Attribute init table {0} initializes {1}, but the ASC has no attribute set for it.", GetName(), Attribute.GetName());
+			continue;
+		}
+
+		if (FGameplayAttributeData* Data = Attribute.GetGameplayAttributeData(Set))
+		{
+			Data->SetBaseValue(Value);
+			Data->SetCurrentValue(Value);
+		}
+		else
+		{
+			Attribute.SetNumericValueChecked(Value, Set);
+		}
+
+		if (UARPGAttributeSet* ARPGSet = Cast<UARPGAttributeSet>(Set))
+		{
+			DirectlyInitializedSets.AddUnique(ARPGSet);
+		}
+	}
+
+	for (UARPGAttributeSet* Set : DirectlyInitializedSets)
+	{
+		Set->PostDirectAttributeInit();
+	}
+
+	return true;
+}
+
+const UARPGAttributeInitTable::FResolvedArchetype* UARPGAttributeInitTable::ResolveArchetype(FName ArchetypeName, int32 Level) const
+{
+	check(IsInGameThread());
+
+	const TPair<FName, int32> Key(ArchetypeName, Level);
+	if (const FResolvedArchetype* Cached = ResolvedArchetypes.Find(Key))
+	{
+		return Cached;
+	}
+
+	const FARPGAttributeInitArchetype* Archetype = Archetypes.FindByPredicate([ArchetypeName](const FARPGAttributeInitArchetype& Candidate)
+		{
+			return Candidate.ArchetypeName == ArchetypeName;
+		});
+
+	if (!Archetype)
+	{
+		return nullptr;
+	}
+
+	const FString ContextString = FString::Printf(TEXT("%s.%s"), *GetName(), *ArchetypeName.ToString());
+
+	FResolvedArchetype& Resolved = ResolvedArchetypes.Add(Key);
+	Resolved.Attributes.Reserve(Archetype->Attributes.Num());
+	Resolved.Values.Reserve(Archetype->Attributes.Num());
+
+	for (const FARPGAttributeInitEntry& Entry : Archetype->Attributes)
+	{
+		if (!Entry.Attribute.IsValid())
+		{
+			UE_LOGFMT(LogTemp, Error, "Attribute init table {0} has an entry with no attribute in archetype {1}, skipping it.", GetName(), ArchetypeName);
+			continue;
+		}
+
+		Resolved.Attributes.Add(Entry.Attribute);
+		Resolved.Values.Add(Entry.Value.GetValueAtLevel(static_cast<float>(Level), &ContextString));
+	}
+
+	return &Resolved;
+}
+
+#if WITH_EDITOR
+void UARPGAttributeInitTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	ResolvedArchetypes.Reset();
+}
+#endif
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "AttributeSet.h"
+#include "ScalableFloat.h"
+#include "ARPGAttributeInitTable.generated.h"
+
+class UARPGAbilitySystemComponent;
+
+/**
+ * FARPGAttributeInitEntry
+ *
+ *	Initial value for a single attribute.
+ */
+USTRUCT(BlueprintType)
+struct FARPGAttributeInitEntry
+{
+	GENERATED_BODY()
+public:
+	// Attribute to initialize
+	UPROPERTY(EditDefaultsOnly)
+	FGameplayAttribute Attribute;
+
+	// Initial value of the attribute. If this references a curve table row, it is evaluated at the character's level.
+	UPROPERTY(EditDefaultsOnly)
+	FScalableFloat Value;
+};
+
+/**
+ * FARPGAttributeInitArchetype
+ *
+ *	Initial attribute values shared by every character of an archetype (e.g., "Skeleton.Archer").
+ */
+USTRUCT(BlueprintType)
+struct FARPGAttributeInitArchetype
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditDefaultsOnly)
+	FName ArchetypeName;
+
+	UPROPERTY(EditDefaultsOnly, meta = (TitleProperty = Attribute))
+	TArray<FARPGAttributeInitEntry> Attributes;
+};
+
+/**
+ * UARPGAttributeInitTable
+ *
+ *	Data-driven starting attributes, keyed by archetype and level.
+ *
+ *	Characters of the same archetype and level always start with identical values, so the values are
+ *	evaluated once per (archetype, level) pair and cached. Applying the table writes the cached values
+ *	straight into the ASC's attribute sets instead of applying an initialization gameplay effect to
+ *	every spawned character.
+ */
+UCLASS(BlueprintType, Const)
+class ARPG_API UARPGAttributeInitTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * @brief Writes the starting attributes of an archetype into the attribute sets of the ASC.
+	 *	Should only be called on the authority, when the character is spawned (before any effects have been applied).
+	 *
+	 * @param ASC The ability system component to initialize. Its attribute sets must already exist.
+	 * @param ArchetypeName Name of the archetype to look up
+	 * @param Level Level used to evaluate curve-based values
+	 * @return True if the archetype was found and applied
+	 */
+	bool ApplyToAbilitySystem(UARPGAbilitySystemComponent* ASC, FName ArchetypeName, int32 Level) const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Attributes", meta = (TitleProperty = ArchetypeName))
+	TArray<FARPGAttributeInitArchetype> Archetypes;
+
+private:
+	/** Values of an archetype evaluated at a specific level. Stored as parallel arrays so applying them is a linear walk. */
+	struct FResolvedArchetype
+	{
+		TArray<FGameplayAttribute> Attributes;
+		TArray<float> Values;
+	};
+
+	/** Evaluates (or fetches the cached values of) an archetype at a level. Returns nullptr if the archetype doesn't exist. */
+	const FResolvedArchetype* ResolveArchetype(FName ArchetypeName, int32 Level) const;
+
+	mutable TMap<TPair<FName, int32>, FResolvedArchetype> ResolvedArchetypes;
+};
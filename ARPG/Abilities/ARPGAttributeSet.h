@@ -17,7 +17,11 @@ class ARPG_API UARPGAttributeSet : public UAttributeSet
 public:
 	UARPGAttributeSet();
 
-
+	/**
+	 * Called after attribute values were written directly into this set, bypassing the active effects container
+	 * (see UARPGAttributeInitTable). No attribute change callbacks have fired for those writes.
+	 */
+	virtual void PostDirectAttributeInit() {}
 
 
 };
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGDamageBatchSubsystem.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Logging/StructuredLog.h"
+#include "ARPGGameplayEffect_Damage.h"
+#include "ARPG/Core/ARPGNativeGameplayTags.h"
+
+UARPGDamageBatchSubsystem* UARPGDamageBatchSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGDamageBatchSubsystem>() : nullptr;
+}
+
+void UARPGDamageBatchSubsystem::QueueDamage(AActor* Target, float Damage, AActor* Instigator)
+{
+	QueueDamageToAbilitySystem(UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Target), Damage, Instigator);
+}
+
+void UARPGDamageBatchSubsystem::QueueDamageToAbilitySystem(UAbilitySystemComponent* TargetASC, float Damage, AActor* Instigator, uint32 HitId)
+{
+	if (!TargetASC || Damage <= 0.f)
+	{
+		return;
+	}
+
+	if (!TargetASC->IsOwnerActorAuthoritative())
+	{
+		UE_LOGFMT(LogTemp, Verbose, "Tried to queue damage against {0} without authority, ignoring it.", GetNameSafe(TargetASC->GetOwner()));
+		return;
+	}
+
+	const TObjectKey<UAbilitySystemComponent> TargetKey(TargetASC);
+	if (const int32* ExistingIndex = PendingDamageIndices.Find(TargetKey))
+	{
+		FPendingDamage& Pending = PendingDamage[*ExistingIndex];
+		if (HitId != 0)
+		{
+			if (Pending.HitIds.Contains(HitId))
+			{
+				UE_LOGFMT(LogTemp, Verbose, "Ignored duplicate hit {0} on {1}.", HitId, GetNameSafe(TargetASC->GetOwner()));
+				return;
+			}
+			Pending.HitIds.Add(HitId);
+		}
+
+		INC_DWORD_STAT(STAT_ARPGDamageBatch_HitsQueued);
+		++PendingHits;
+
+		Pending.Damage += Damage;
+		Pending.Instigator = Instigator;
+		++Pending.NumHits;
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_ARPGDamageBatch_HitsQueued);
+	++PendingHits;
+
+	FPendingDamage& Pending = PendingDamage.AddDefaulted_GetRef();
+	Pending.TargetASC = TargetASC;
+	Pending.Instigator = Instigator;
+	Pending.Damage = Damage;
+	Pending.NumHits = 1;
+	if (HitId != 0)
+	{
+		Pending.HitIds.Add(HitId);
+	}
+
+	PendingDamageIndices.Add(TargetKey, PendingDamage.Num() - 1);
+}
+
+void UARPGDamageBatchSubsystem::FlushPendingDamage()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGDamageBatch_Flush);
+
+	if (PendingDamage.Num() == 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Swap out the queue so damage queued while applying (e.g., by effects reacting to damage) lands in the next batch
+	TArray<FPendingDamage> Batch = MoveTemp(PendingDamage);
+	const int32 BatchHits = PendingHits;
+	PendingDamage.Reset();
+	PendingDamageIndices.Reset();
+	PendingHits = 0;
+
+	const UGameplayEffect* DamageEffect = GetDefault<UARPGGameplayEffect_Damage>();
+	int32 TargetsApplied = 0;
+
+	for (const FPendingDamage& Pending : Batch)
+	{
+		UAbilitySystemComponent* TargetASC = Pending.TargetASC.Get();
+		if (!TargetASC)
+		{
+			// Target was destroyed before the end of the frame
+			continue;
+		}
+
+		AActor* Instigator = Pending.Instigator.Get();
+
+		FGameplayEffectContextHandle EffectContextHandle(UAbilitySystemGlobals::Get().AllocGameplayEffectContext());
+		EffectContextHandle.AddInstigator(Instigator, Instigator);
+
+		FGameplayEffectSpec DamageSpec(DamageEffect, EffectContextHandle, 1.f);
+		DamageSpec.SetSetByCallerMagnitude(SetByCaller_Damage, Pending.Damage);
+
+		TargetASC->ApplyGameplayEffectSpecToSelf(DamageSpec);
+		++TargetsApplied;
+	}
+
+	// Hand the allocation back so the next frame doesn't have to grow the queue again,
+	// unless applying damage queued more damage for the next batch
+	if (PendingDamage.Num() == 0)
+	{
+		Batch.Reset();
+		PendingDamage = MoveTemp(Batch);
+	}
+
+	SET_DWORD_STAT(STAT_ARPGDamageBatch_TargetsApplied, TargetsApplied);
+
+	Stats.HitsLastBatch = BatchHits;
+	Stats.TargetsLastBatch = TargetsApplied;
+	Stats.LastBatchMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	Stats.PeakHitsPerBatch = FMath::Max(Stats.PeakHitsPerBatch, BatchHits);
+}
+
+void UARPGDamageBatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushPendingDamage();
+}
+
+TStatId UARPGDamageBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGDamageBatchSubsystem, STATGROUP_Tickables);
+}
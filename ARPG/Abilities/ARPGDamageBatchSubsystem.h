@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ARPGDamageBatchSubsystem.generated.h"
+
+class UAbilitySystemComponent;
+
+DECLARE_STATS_GROUP(TEXT("ARPGDamage"), STATGROUP_ARPGDamage, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Damage Batch Flush"), STAT_ARPGDamageBatch_Flush, STATGROUP_ARPGDamage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Hits Queued"), STAT_ARPGDamageBatch_HitsQueued, STATGROUP_ARPGDamage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Targets Applied"), STAT_ARPGDamageBatch_TargetsApplied, STATGROUP_ARPGDamage);
+
+/**
+ * Stats about the most recent damage batch. Exposed so they can be shown in debug UI.
+ */
+USTRUCT(BlueprintType)
+struct FARPGDamageBatchStats
+{
+	GENERATED_BODY()
+
+	// Number of hits queued during the last flushed frame
+	UPROPERTY(BlueprintReadOnly, Category = "Damage")
+	int32 HitsLastBatch = 0;
+
+	// Number of targets that received damage in the last flushed frame (one gameplay effect each)
+	UPROPERTY(BlueprintReadOnly, Category = "Damage")
+	int32 TargetsLastBatch = 0;
+
+	// Time spent applying the last batch, in milliseconds
+	UPROPERTY(BlueprintReadOnly, Category = "Damage")
+	float LastBatchMs = 0.f;
+
+	// Largest number of hits seen in a single frame
+	UPROPERTY(BlueprintReadOnly, Category = "Damage")
+	int32 PeakHitsPerBatch = 0;
+};
+
+/**
+ * Server-side batcher for damage.
+ *
+ * Instead of every hit applying its own gameplay effect, hits (from weapon traces and abilities) are queued
+ * during the frame and summed per target. At the end of the frame every damaged target receives a single
+ * UARPGGameplayEffect_Damage with the combined amount, so an AoE hitting 50 enemies with 3 hits each costs
+ * 50 effect executions instead of 150.
+ */
+UCLASS()
+class ARPG_API UARPGDamageBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the damage batcher of the world the context object lives in */
+	static UARPGDamageBatchSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * @brief Queues damage against the ASC of the target actor. It will be applied at the end of the frame,
+	 *	combined with every other hit the target received this frame. Ignored if not called on the authority.
+	 *
+	 * @param Target Actor receiving the damage. Must have an ability system component.
+	 * @param Damage Amount of damage to deal (before any processing done by the target's attribute sets)
+	 * @param Instigator Actor responsible for the damage
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Damage")
+	void QueueDamage(AActor* Target, float Damage, AActor* Instigator);
+
+	/**
+	 * Same as QueueDamage, but for callers that already resolved the target's ASC.
+	 * @param HitId Optional id of the attack (e.g., a weapon trace swing id). A target only takes one hit per id and frame,
+	 *	so the same hit reported twice (by a trace and a hit claim, or by overlapping sweeps) isn't counted twice. 0 disables this.
+	 */
+	void QueueDamageToAbilitySystem(UAbilitySystemComponent* TargetASC, float Damage, AActor* Instigator, uint32 HitId = 0);
+
+	/** Applies all damage queued so far. Called automatically once per frame. */
+	void FlushPendingDamage();
+
+	UFUNCTION(BlueprintCallable, Category = "Damage|Debug")
+	const FARPGDamageBatchStats& GetStats() const { return Stats; }
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	struct FPendingDamage
+	{
+		TWeakObjectPtr<UAbilitySystemComponent> TargetASC;
+
+		// The last instigator to hit the target this frame, used as the instigator of the combined effect
+		TWeakObjectPtr<AActor> Instigator;
+
+		float Damage = 0.f;
+
+		int32 NumHits = 0;
+
+		// Ids of the attacks that hit the target this frame
+		TArray<uint32, TInlineAllocator<4>> HitIds;
+	};
+
+	/** Damage waiting to be applied, one entry per target */
+	TArray<FPendingDamage> PendingDamage;
+
+	/** Index into PendingDamage for each target */
+	TMap<TObjectKey<UAbilitySystemComponent>, int32> PendingDamageIndices;
+
+	/** Number of hits queued since the last flush */
+	int32 PendingHits = 0;
+
+	FARPGDamageBatchStats Stats;
+};
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGGameplayEffect_Damage.h"
+#include "ARPGHealthAttributeSet.h"
+#include "ARPG/Core/ARPGNativeGameplayTags.h"
+
+UARPGGameplayEffect_Damage::UARPGGameplayEffect_Damage()
+{
+	DurationPolicy = EGameplayEffectDurationType::Instant;
+
+	FSetByCallerFloat DamageMagnitude;
+	DamageMagnitude.DataTag = SetByCaller_Damage;
+
+	FGameplayModifierInfo DamageModifier;
+	DamageModifier.Attribute = UARPGHealthAttributeSet::GetDamageAttribute();
+	DamageModifier.ModifierOp = EGameplayModOp::Additive;
+	DamageModifier.ModifierMagnitude = FGameplayEffectModifierMagnitude(DamageMagnitude);
+
+	Modifiers.Add(DamageModifier);
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayEffect.h"
+#include "ARPGGameplayEffect_Damage.generated.h"
+
+/**
+ * Instant gameplay effect that adds to the Damage meta attribute of the target.
+ * The amount of damage is passed with the SetByCaller.Damage tag.
+ *
+ * Defined in C++ so systems like the damage batcher can rely on it existing without any asset setup.
+ */
+UCLASS()
+class ARPG_API UARPGGameplayEffect_Damage : public UGameplayEffect
+{
+	GENERATED_BODY()
+
+public:
+	UARPGGameplayEffect_Damage();
+};
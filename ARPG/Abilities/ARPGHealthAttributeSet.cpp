@@ -6,12 +6,67 @@
 #include "Logging/StructuredLog.h"
 #include "ARPG/Core/ARPGViewModelPlayerStats.h"
 #include "MVVMGameSubsystem.h"
+#include "GameplayEffectExtension.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "Engine/World.h"
+
+namespace ARPGHealthReplication
+{
+	static TAutoConsoleVariable<bool> CVarQuantizeHealth(
+		TEXT("ARPG.Net.QuantizeHealth"),
+		true,
+		TEXT("If true, only the owner receives full precision health attributes. Everyone else receives a quantized copy. Read at startup."),
+		ECVF_ReadOnly);
+
+	static TAutoConsoleVariable<float> CVarQuantizedHealthMinInterval(
+		TEXT("ARPG.Net.QuantizedHealthMinInterval"),
+		0.25f,
+		TEXT("Minimum seconds between quantized health updates. Small changes arriving faster are coalesced, health reaching or leaving zero is always sent immediately."),
+		ECVF_Default);
+}
+
+bool FARPGNetQuantizedHealth::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar.SerializeIntPacked(HealthMax);
+
+	uint32 Fraction = HealthFraction;
+	Ar.SerializeInt(Fraction, FractionMax + 1);
+	HealthFraction = static_cast<uint16>(Fraction);
+
+	bOutSuccess = true;
+	return true;
+}
+
+void FARPGNetQuantizedHealth::Quantize(float InHealth, float InHealthMax)
+{
+	HealthMax = static_cast<uint32>(FMath::RoundToInt(FMath::Max(InHealthMax, 0.0f)));
+
+	if (InHealthMax <= 0.0f || InHealth <= 0.0f)
+	{
+		HealthFraction = 0;
+		return;
+	}
+
+	const float Ratio = FMath::Clamp(InHealth / InHealthMax, 0.0f, 1.0f);
+	HealthFraction = static_cast<uint16>(FMath::Clamp<int32>(FMath::RoundToInt(Ratio * FractionMax), 1, FractionMax));
+}
+
+float FARPGNetQuantizedHealth::GetHealth() const
+{
+	return static_cast<float>(HealthMax) * HealthFraction / FractionMax;
+}
 
 UARPGHealthAttributeSet::UARPGHealthAttributeSet()
 {
 
 }
 
+bool UARPGHealthAttributeSet::IsHealthQuantizationEnabled()
+{
+	return ARPGHealthReplication::CVarQuantizeHealth.GetValueOnGameThread();
+}
+
 // Client only - This is not invoked when playing in standalone mode
 void UARPGHealthAttributeSet::OnRep_Health(const FGameplayAttributeData& OldHealth)
 {
@@ -25,53 +80,214 @@ void UARPGHealthAttributeSet::OnRep_HealthMax(const FGameplayAttributeData& OldH
 	GetOwningAbilitySystemComponent()->SetBaseAttributeValueFromReplication(GetHealthMaxAttribute(), GetHealthMax(), OldHealthMax.GetCurrentValue());
 }
 
+// Client only - Simulated proxies receive health through this instead of OnRep_Health/OnRep_HealthMax
+void UARPGHealthAttributeSet::OnRep_QuantizedHealth()
+{
+	UAbilitySystemComponent* ASC = GetOwningAbilitySystemComponent();
+	if (!ASC)
+	{
+		return;
+	}
+
+	// Health max first so listeners never see health above health max
+	const float OldHealthMax = GetHealthMax();
+	const float NewHealthMax = QuantizedHealth.GetHealthMax();
+	if (OldHealthMax != NewHealthMax)
+	{
+		HealthMax.SetBaseValue(NewHealthMax);
+		HealthMax.SetCurrentValue(NewHealthMax);
+		ASC->SetBaseAttributeValueFromReplication(GetHealthMaxAttribute(), NewHealthMax, OldHealthMax);
+	}
+
+	const float OldHealth = GetHealth();
+	const float NewHealth = QuantizedHealth.GetHealth();
+	if (OldHealth != NewHealth)
+	{
+		Health.SetBaseValue(NewHealth);
+		Health.SetCurrentValue(NewHealth);
+		ASC->SetBaseAttributeValueFromReplication(GetHealthAttribute(), NewHealth, OldHealth);
+	}
+}
+
+void UARPGHealthAttributeSet::PreAttributeBaseChange(const FGameplayAttribute& Attribute, float& NewValue) const
+{
+	Super::PreAttributeBaseChange(Attribute, NewValue);
+
+	ClampAttribute(Attribute, NewValue);
+}
+
 void UARPGHealthAttributeSet::PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue)
 {
 	Super::PreAttributeChange(Attribute, NewValue);
+
+	ClampAttribute(Attribute, NewValue);
 }
 
 void UARPGHealthAttributeSet::PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue)
 {
 	Super::PostAttributeChange(Attribute, OldValue, NewValue);
 
-	if (Attribute == GetHealingAttribute())
+	// Health max shrank below the current health, bring health back in range
+	if (Attribute == GetHealthMaxAttribute() && NewValue > 0.0f && GetHealth() > NewValue)
 	{
-		const float HealingDone = NewValue;
-
-		if (HealingDone > 0.0f)
+		if (UAbilitySystemComponent* ASC = GetOwningAbilitySystemComponent())
 		{
-			SetHealing(0.0f);
+			ASC->ApplyModToAttribute(GetHealthAttribute(), EGameplayModOp::Override, NewValue);
+		}
+	}
 
-			const float NewHealth = FMath::Clamp(GetHealth() + HealingDone, 0.0f, GetHealthMax());
+	if (bOutOfHealth && Attribute == GetHealthAttribute() && NewValue > 0.0f)
+	{
+		bOutOfHealth = false;
+	}
 
-			SetHealth(NewHealth);
-		}
+	if (Attribute == GetHealthAttribute() || Attribute == GetHealthMaxAttribute())
+	{
+		UpdateQuantizedHealth();
 	}
-	else if (Attribute == GetDamageAttribute())
+}
+
+void UARPGHealthAttributeSet::PostDirectAttributeInit()
+{
+	Super::PostDirectAttributeInit();
+
+	UpdateQuantizedHealth();
+}
+
+// Server only - Damage and healing are meta attributes, they are resolved into health here exactly once per effect execution
+void UARPGHealthAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data)
+{
+	Super::PostGameplayEffectExecute(Data);
+
+	const float HealthBefore = GetHealth();
+	float Magnitude = 0.0f;
+
+	if (Data.EvaluatedData.Attribute == GetDamageAttribute())
 	{
+		Magnitude = GetDamage();
 
-		const float DamageDone = NewValue;
+		// Meta attributes are never modified over time, so reset them in place without triggering change notifications
+		InitDamage(0.0f);
 
-		if (DamageDone > 0.0f)
+		if (Magnitude > 0.0f)
 		{
-			SetDamage(0.0f);
-
-			const float NewHealth = FMath::Clamp(GetHealth() - DamageDone, 0.0f, GetHealthMax());
+			SetHealth(FMath::Clamp(HealthBefore - Magnitude, 0.0f, GetHealthMax()));
+		}
+	}
+	else if (Data.EvaluatedData.Attribute == GetHealingAttribute())
+	{
+		Magnitude = GetHealing();
+		InitHealing(0.0f);
 
-			SetHealth(NewHealth);
+		if (Magnitude > 0.0f)
+		{
+			SetHealth(FMath::Clamp(HealthBefore + Magnitude, 0.0f, GetHealthMax()));
 		}
 	}
+	else
+	{
+		return;
+	}
+
+	if (GetHealth() <= 0.0f && !bOutOfHealth)
+	{
+		bOutOfHealth = true;
+
+		const FGameplayEffectContextHandle& EffectContext = Data.EffectSpec.GetEffectContext();
+		AActor* Instigator = EffectContext.GetOriginalInstigator();
+		AActor* Causer = EffectContext.GetEffectCauser();
+
+		OnOutOfHealth.Broadcast(Instigator, Causer, &Data.EffectSpec, Magnitude, HealthBefore, GetHealth());
+	}
+	else if (GetHealth() > 0.0f)
+	{
+		bOutOfHealth = false;
+	}
 }
 
-void UARPGHealthAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data)
+void UARPGHealthAttributeSet::ClampAttribute(const FGameplayAttribute& Attribute, float& NewValue) const
 {
-	Super::PostGameplayEffectExecute(Data);
+	if (Attribute == GetHealthAttribute())
+	{
+		// Health max is 0 until the attribute set has been initialized, don't clamp against it until then
+		const float HealthMaxValue = GetHealthMax();
+		NewValue = HealthMaxValue > 0.0f ? FMath::Clamp(NewValue, 0.0f, HealthMaxValue) : FMath::Max(NewValue, 0.0f);
+	}
+	else if (Attribute == GetHealthMaxAttribute())
+	{
+		NewValue = FMath::Max(NewValue, 0.0f);
+	}
+}
+
+void UARPGHealthAttributeSet::UpdateQuantizedHealth()
+{
+	const AActor* OwningActor = GetOwningActor();
+	if (!IsHealthQuantizationEnabled() || !OwningActor || !OwningActor->HasAuthority())
+	{
+		return;
+	}
+
+	FARPGNetQuantizedHealth NewQuantizedHealth;
+	NewQuantizedHealth.Quantize(GetHealth(), GetHealthMax());
+	if (NewQuantizedHealth == QuantizedHealth)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	const float MinInterval = ARPGHealthReplication::CVarQuantizedHealthMinInterval.GetValueOnGameThread();
+
+	// Always send health max changes and transitions to or from zero health right away, coalesce everything else
+	const bool bCriticalChange = NewQuantizedHealth.HealthMax != QuantizedHealth.HealthMax
+		|| (NewQuantizedHealth.HealthFraction == 0) != (QuantizedHealth.HealthFraction == 0);
+
+	if (bCriticalChange || !World || MinInterval <= 0.0f || LastQuantizedHealthWriteTime < 0.0)
+	{
+		FlushQuantizedHealth();
+		return;
+	}
+
+	const double TimeSinceLastWrite = World->GetTimeSeconds() - LastQuantizedHealthWriteTime;
+	if (TimeSinceLastWrite >= MinInterval)
+	{
+		FlushQuantizedHealth();
+		return;
+	}
+
+	FTimerManager& TimerManager = World->GetTimerManager();
+	if (!TimerManager.IsTimerActive(QuantizedHealthTimerHandle))
+	{
+		TimerManager.SetTimer(QuantizedHealthTimerHandle, FTimerDelegate::CreateUObject(this, &UARPGHealthAttributeSet::FlushQuantizedHealth), MinInterval - TimeSinceLastWrite, false);
+	}
+}
+
+void UARPGHealthAttributeSet::FlushQuantizedHealth()
+{
+	UWorld* World = GetWorld();
+	if (World)
+	{
+		World->GetTimerManager().ClearTimer(QuantizedHealthTimerHandle);
+		LastQuantizedHealthWriteTime = World->GetTimeSeconds();
+	}
+
+	QuantizedHealth.Quantize(GetHealth(), GetHealthMax());
 }
 
 void UARPGHealthAttributeSet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, Health, COND_None, REPNOTIFY_Always);
-	DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, HealthMax, COND_None, REPNOTIFY_Always);
+	if (IsHealthQuantizationEnabled())
+	{
+		// The owner keeps full precision attributes so its predicted changes can be reconciled, everyone else gets the quantized copy
+		DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, Health, COND_OwnerOnly, REPNOTIFY_Always);
+		DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, HealthMax, COND_OwnerOnly, REPNOTIFY_Always);
+		DOREPLIFETIME_CONDITION(UARPGHealthAttributeSet, QuantizedHealth, COND_SkipOwner);
+	}
+	else
+	{
+		DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, Health, COND_None, REPNOTIFY_Always);
+		DOREPLIFETIME_CONDITION_NOTIFY(UARPGHealthAttributeSet, HealthMax, COND_None, REPNOTIFY_Always);
+		DOREPLIFETIME_CONDITION(UARPGHealthAttributeSet, QuantizedHealth, COND_Never);
+	}
 }
@@ -5,8 +5,72 @@
 #include "CoreMinimal.h"
 #include "ARPGAttributeSet.h"
 #include "ARPGAbilityHelpers.h"
+#include "Engine/TimerHandle.h"
 #include "ARPGHealthAttributeSet.generated.h"
 
+struct FGameplayEffectSpec;
+
+/**
+ * Delegate used to broadcast attribute events.
+ *
+ * @param EffectInstigator	The original instigating actor for this event
+ * @param EffectCauser		The physical actor that caused the change
+ * @param EffectSpec		The full effect spec for this change
+ * @param EffectMagnitude	The raw magnitude, this is before clamping
+ * @param OldValue			The value of the attribute before it was changed
+ * @param NewValue			The value after it was changed
+ */
+DECLARE_MULTICAST_DELEGATE_SixParams(FARPGAttributeEvent, AActor* /*EffectInstigator*/, AActor* /*EffectCauser*/, const FGameplayEffectSpec* /*EffectSpec*/, float /*EffectMagnitude*/, float /*OldValue*/, float /*NewValue*/);
+
+/**
+ * Compact copy of health replicated to simulated proxies instead of the full attribute data.
+ * Health max is sent as a packed integer and health as a fixed point fraction of it.
+ */
+USTRUCT()
+struct ARPG_API FARPGNetQuantizedHealth
+{
+	GENERATED_BODY()
+
+	static constexpr int32 FractionBits = 10;
+	static constexpr uint32 FractionMax = (1u << FractionBits) - 1;
+
+	/** Health as a fraction of HealthMax, in [0, FractionMax] */
+	UPROPERTY()
+	uint16 HealthFraction = 0;
+
+	/** Health max rounded to the nearest integer */
+	UPROPERTY()
+	uint32 HealthMax = 0;
+
+	/** Quantizes the given values into this struct. Non-zero health never quantizes to zero */
+	void Quantize(float InHealth, float InHealthMax);
+
+	float GetHealth() const;
+	float GetHealthMax() const { return static_cast<float>(HealthMax); }
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FARPGNetQuantizedHealth& Other) const
+	{
+		return HealthFraction == Other.HealthFraction && HealthMax == Other.HealthMax;
+	}
+
+	bool operator!=(const FARPGNetQuantizedHealth& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FARPGNetQuantizedHealth> : public TStructOpsTypeTraitsBase2<FARPGNetQuantizedHealth>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
+
 /**
  * Attribute set that manages the health of a character in the world.
  * 
@@ -27,6 +91,17 @@ public:
 	ATTRIBUTE_ACCESSORS(UARPGHealthAttributeSet, Damage);
 	ATTRIBUTE_ACCESSORS(UARPGHealthAttributeSet, Healing);
 
+	/**
+	 * Broadcast (server only) when health reaches zero. Fires exactly once until health is restored above zero.
+	 * Mutable so listeners can bind through the const attribute set pointers held by characters.
+	 */
+	mutable FARPGAttributeEvent OnOutOfHealth;
+
+	/** True if simulated proxies receive health through QuantizedHealth instead of the full attributes. See ARPG.Net.QuantizeHealth */
+	static bool IsHealthQuantizationEnabled();
+
+	virtual void PostDirectAttributeInit() override;
+
 protected:
 	UFUNCTION()
 	virtual void OnRep_Health(const FGameplayAttributeData& OldHealth);
@@ -34,12 +109,25 @@ protected:
 	UFUNCTION()
 	virtual void OnRep_HealthMax(const FGameplayAttributeData& OldHealthMax);
 
+	UFUNCTION()
+	virtual void OnRep_QuantizedHealth();
 
+
+	virtual void PreAttributeBaseChange(const FGameplayAttribute& Attribute, float& NewValue) const override;
 	virtual void PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue) override;
 	virtual void PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) override;
 
 	virtual void PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data) override;
 
+	/** Clamps health related attributes to their valid ranges */
+	void ClampAttribute(const FGameplayAttribute& Attribute, float& NewValue) const;
+
+	/** Server only - Refreshes QuantizedHealth, coalescing small changes that arrive faster than ARPG.Net.QuantizedHealthMinInterval */
+	void UpdateQuantizedHealth();
+
+	/** Server only - Writes the current health into QuantizedHealth */
+	void FlushQuantizedHealth();
+
 	/** Used to specify which properties this Actor should replicate (manually overriding this for fine tuned control over attribute replication) */
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
@@ -68,4 +156,17 @@ private:
 	 */
 	UPROPERTY(BlueprintReadOnly, Category = "Healing", Meta = (AllowPrivateAccess = true))
 	FGameplayAttributeData Healing;
+
+	/** Health replicated to everyone but the owner when health quantization is enabled */
+	UPROPERTY(ReplicatedUsing = OnRep_QuantizedHealth)
+	FARPGNetQuantizedHealth QuantizedHealth;
+
+	/** Pending deferred write of QuantizedHealth */
+	FTimerHandle QuantizedHealthTimerHandle;
+
+	/** World time of the last QuantizedHealth write */
+	double LastQuantizedHealthWriteTime = -1.0;
+
+	/** True once OnOutOfHealth has been broadcast, reset when health goes back above zero */
+	bool bOutOfHealth = false;
 };
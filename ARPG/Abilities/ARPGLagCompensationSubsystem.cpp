@@ -0,0 +1,398 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGLagCompensationSubsystem.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ARPGLagCompensation
+{
+	static TAutoConsoleVariable<int32> CVarHistoryMs(
+		TEXT("ARPG.LagComp.HistoryMs"),
+		1000,
+		TEXT("How many milliseconds of character capsule history the server keeps for lag compensation. Changing it clears the history."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarSampleRate(
+		TEXT("ARPG.LagComp.SampleRate"),
+		60.f,
+		TEXT("How many times per second the server records character capsules for lag compensation. Changing it clears the history."),
+		ECVF_Default);
+
+	/** Distance between a segment and a vertical capsule, measured to the capsule's axis */
+	static float SegmentToCapsuleAxisDistance(const FVector& Start, const FVector& End, const FVector& Center, float Radius, float HalfHeight)
+	{
+		const FVector CapsuleAxis = FVector::UpVector * FMath::Max(HalfHeight - Radius, 0.f);
+		FVector ClosestOnSegment;
+		FVector ClosestOnCapsule;
+		FMath::SegmentDistToSegmentSafe(Start, End, Center - CapsuleAxis, Center + CapsuleAxis, ClosestOnSegment, ClosestOnCapsule);
+		return FVector::Dist(ClosestOnSegment, ClosestOnCapsule);
+	}
+}
+
+void FARPGCapsuleHistory::Configure(int32 InFrameCapacity)
+{
+	FrameCapacity = FMath::Max(InFrameCapacity, 2);
+	SlotCapacity = 0;
+	OldestFrame = 0;
+	NumFrames = 0;
+
+	FrameTimes.SetNumZeroed(FrameCapacity);
+	Locations.Empty();
+	SlotRadii.Empty();
+	SlotHalfHeights.Empty();
+	SlotFirstTimes.Empty();
+	ActiveSlots.Empty();
+	FreeSlots.Empty();
+}
+
+int32 FARPGCapsuleHistory::AddSlot(float Radius, float HalfHeight)
+{
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Slot = SlotRadii.Num();
+		SlotRadii.AddUninitialized();
+		SlotHalfHeights.AddUninitialized();
+		SlotFirstTimes.AddUninitialized();
+		ActiveSlots.Add(false);
+
+		if (Slot >= SlotCapacity)
+		{
+			GrowSlots(FMath::Max(SlotCapacity * 2, 16));
+		}
+	}
+
+	SlotRadii[Slot] = Radius;
+	SlotHalfHeights[Slot] = HalfHeight;
+	// Frames recorded before now belong to whoever had the slot before
+	SlotFirstTimes[Slot] = TNumericLimits<double>::Max();
+	ActiveSlots[Slot] = true;
+	return Slot;
+}
+
+void FARPGCapsuleHistory::RemoveSlot(int32 Slot)
+{
+	if (ActiveSlots.IsValidIndex(Slot) && ActiveSlots[Slot])
+	{
+		ActiveSlots[Slot] = false;
+		FreeSlots.Add(Slot);
+	}
+}
+
+void FARPGCapsuleHistory::GrowSlots(int32 NewSlotCapacity)
+{
+	TArray<FVector3f> NewLocations;
+	NewLocations.SetNumZeroed(FrameCapacity * NewSlotCapacity);
+
+	for (int32 Frame = 0; Frame < FrameCapacity && SlotCapacity > 0; ++Frame)
+	{
+		FMemory::Memcpy(&NewLocations[Frame * NewSlotCapacity], &Locations[Frame * SlotCapacity], SlotCapacity * sizeof(FVector3f));
+	}
+
+	Locations = MoveTemp(NewLocations);
+	SlotCapacity = NewSlotCapacity;
+}
+
+TArrayView<FVector3f> FARPGCapsuleHistory::AddFrame(double Time)
+{
+	int32 Frame;
+	if (NumFrames < FrameCapacity)
+	{
+		Frame = GetFrameIndex(NumFrames);
+		++NumFrames;
+	}
+	else
+	{
+		Frame = OldestFrame;
+		OldestFrame = (OldestFrame + 1) % FrameCapacity;
+	}
+
+	FrameTimes[Frame] = Time;
+
+	// Slots added since the last frame start their history here
+	for (TConstSetBitIterator<> It(ActiveSlots); It; ++It)
+	{
+		double& FirstTime = SlotFirstTimes[It.GetIndex()];
+		FirstTime = FMath::Min(FirstTime, Time);
+	}
+
+	return TArrayView<FVector3f>(SlotCapacity > 0 ? &Locations[Frame * SlotCapacity] : nullptr, SlotRadii.Num());
+}
+
+bool FARPGCapsuleHistory::FindFrames(double Time, int32& OutFrameA, int32& OutFrameB, float& OutAlpha) const
+{
+	if (NumFrames == 0)
+	{
+		return false;
+	}
+
+	// Frame times are increasing from the oldest frame, binary search for the first frame after Time
+	int32 Low = 0;
+	int32 High = NumFrames;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (FrameTimes[GetFrameIndex(Mid)] <= Time)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	if (Low == 0 || Low == NumFrames)
+	{
+		// Before the oldest or after the newest frame, clamp
+		OutFrameA = OutFrameB = GetFrameIndex(Low == 0 ? 0 : NumFrames - 1);
+		OutAlpha = 0.f;
+		return true;
+	}
+
+	OutFrameA = GetFrameIndex(Low - 1);
+	OutFrameB = GetFrameIndex(Low);
+	const double TimeA = FrameTimes[OutFrameA];
+	const double TimeB = FrameTimes[OutFrameB];
+	OutAlpha = TimeB > TimeA ? static_cast<float>((Time - TimeA) / (TimeB - TimeA)) : 0.f;
+	return true;
+}
+
+double FARPGCapsuleHistory::ClampToSlotHistory(int32 Slot, double Time) const
+{
+	return FMath::Max(Time, SlotFirstTimes[Slot]);
+}
+
+bool FARPGCapsuleHistory::GetLocationAtTime(int32 Slot, double Time, FVector& OutLocation) const
+{
+	if (!ActiveSlots.IsValidIndex(Slot) || !ActiveSlots[Slot] || SlotFirstTimes[Slot] == TNumericLimits<double>::Max())
+	{
+		return false;
+	}
+
+	int32 FrameA;
+	int32 FrameB;
+	float Alpha;
+	if (!FindFrames(ClampToSlotHistory(Slot, Time), FrameA, FrameB, Alpha))
+	{
+		return false;
+	}
+
+	OutLocation = FVector(FMath::Lerp(Locations[FrameA * SlotCapacity + Slot], Locations[FrameB * SlotCapacity + Slot], Alpha));
+	return true;
+}
+
+void FARPGCapsuleHistory::QuerySegment(double Time, const FVector& Start, const FVector& End, float Radius, TArray<FSegmentHit>& OutHits) const
+{
+	int32 FrameA;
+	int32 FrameB;
+	float Alpha;
+	if (!FindFrames(Time, FrameA, FrameB, Alpha))
+	{
+		return;
+	}
+
+	const FVector3f* LocationsA = &Locations[FrameA * SlotCapacity];
+	const FVector3f* LocationsB = &Locations[FrameB * SlotCapacity];
+
+	// Cheap bounds rejection before the exact segment to capsule test
+	const FVector SegmentMin = Start.ComponentMin(End);
+	const FVector SegmentMax = Start.ComponentMax(End);
+
+	for (TConstSetBitIterator<> It(ActiveSlots); It; ++It)
+	{
+		const int32 Slot = It.GetIndex();
+		const float SlotRadius = SlotRadii[Slot];
+		const float SlotHalfHeight = SlotHalfHeights[Slot];
+
+		FVector Center;
+		if (Time >= SlotFirstTimes[Slot])
+		{
+			Center = FVector(FMath::Lerp(LocationsA[Slot], LocationsB[Slot], Alpha));
+		}
+		else if (!GetLocationAtTime(Slot, Time, Center))
+		{
+			// Not recorded yet
+			continue;
+		}
+
+		const FVector Reach(SlotRadius + Radius, SlotRadius + Radius, SlotHalfHeight + Radius);
+		if (Center.X + Reach.X < SegmentMin.X || Center.X - Reach.X > SegmentMax.X
+			|| Center.Y + Reach.Y < SegmentMin.Y || Center.Y - Reach.Y > SegmentMax.Y
+			|| Center.Z + Reach.Z < SegmentMin.Z || Center.Z - Reach.Z > SegmentMax.Z)
+		{
+			continue;
+		}
+
+		const float Distance = ARPGLagCompensation::SegmentToCapsuleAxisDistance(Start, End, Center, SlotRadius, SlotHalfHeight);
+		if (Distance <= SlotRadius + Radius)
+		{
+			FSegmentHit& Hit = OutHits.AddDefaulted_GetRef();
+			Hit.Slot = Slot;
+			Hit.Center = Center;
+			Hit.Distance = Distance;
+		}
+	}
+}
+
+UARPGLagCompensationSubsystem* UARPGLagCompensationSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGLagCompensationSubsystem>() : nullptr;
+}
+
+void UARPGLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ApplySettings();
+}
+
+void UARPGLagCompensationSubsystem::Deinitialize()
+{
+	SlotCharacters.Empty();
+	CharacterSlots.Empty();
+	History.Configure(0);
+
+	Super::Deinitialize();
+}
+
+void UARPGLagCompensationSubsystem::ApplySettings()
+{
+	const int32 HistoryMs = FMath::Max(ARPGLagCompensation::CVarHistoryMs.GetValueOnGameThread(), 1);
+	const float SampleRate = FMath::Max(ARPGLagCompensation::CVarSampleRate.GetValueOnGameThread(), 1.f);
+	if (HistoryMs == AppliedHistoryMs && SampleRate == AppliedSampleRate)
+	{
+		return;
+	}
+
+	AppliedHistoryMs = HistoryMs;
+	AppliedSampleRate = SampleRate;
+	NextSampleTime = -1.0;
+
+	// One extra frame so the full history is still covered right before the next sample
+	History.Configure(FMath::CeilToInt(HistoryMs * 0.001f * SampleRate) + 1);
+
+	// Configure dropped the slots, add the characters back
+	TArray<TWeakObjectPtr<ACharacter>> Characters = MoveTemp(SlotCharacters);
+	SlotCharacters.Reset();
+	CharacterSlots.Reset();
+	for (const TWeakObjectPtr<ACharacter>& Character : Characters)
+	{
+		if (Character.IsValid())
+		{
+			RegisterCharacter(Character.Get());
+		}
+	}
+}
+
+void UARPGLagCompensationSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (!Character || !Character->HasAuthority() || CharacterSlots.Contains(Character))
+	{
+		return;
+	}
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	const int32 Slot = History.AddSlot(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+
+	if (Slot >= SlotCharacters.Num())
+	{
+		SlotCharacters.SetNum(Slot + 1);
+	}
+	SlotCharacters[Slot] = Character;
+	CharacterSlots.Add(Character, Slot);
+}
+
+void UARPGLagCompensationSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	int32 Slot;
+	if (CharacterSlots.RemoveAndCopyValue(Character, Slot))
+	{
+		History.RemoveSlot(Slot);
+		SlotCharacters[Slot].Reset();
+	}
+}
+
+bool UARPGLagCompensationSubsystem::GetRewoundCapsule(const AActor* Actor, double ServerTime, FVector& OutCenter, float& OutRadius, float& OutHalfHeight) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGLagCompensation_Query);
+
+	const int32* Slot = CharacterSlots.Find(Actor);
+	if (!Slot || !History.GetLocationAtTime(*Slot, ServerTime, OutCenter))
+	{
+		return false;
+	}
+
+	OutRadius = History.GetSlotRadius(*Slot);
+	OutHalfHeight = History.GetSlotHalfHeight(*Slot);
+	return true;
+}
+
+void UARPGLagCompensationSubsystem::QueryCapsulesAlongSegment(double ServerTime, const FVector& Start, const FVector& End, float Radius, TArray<FRewoundHit>& OutHits, const AActor* IgnoreActor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGLagCompensation_Query);
+
+	QueryScratch.Reset();
+	History.QuerySegment(ServerTime, Start, End, Radius, QueryScratch);
+
+	for (const FARPGCapsuleHistory::FSegmentHit& SegmentHit : QueryScratch)
+	{
+		ACharacter* Character = SlotCharacters[SegmentHit.Slot].Get();
+		if (Character && Character != IgnoreActor)
+		{
+			FRewoundHit& Hit = OutHits.AddDefaulted_GetRef();
+			Hit.Actor = Character;
+			Hit.Center = SegmentHit.Center;
+			Hit.Distance = SegmentHit.Distance;
+		}
+	}
+}
+
+void UARPGLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	ApplySettings();
+
+	// Frames land a little early or late of the schedule, so accept them within a fraction of the interval.
+	// Otherwise a sample rate matching the frame rate skips every other frame.
+	const double Now = World->GetTimeSeconds();
+	const double SampleInterval = 1.0 / AppliedSampleRate;
+	if (NextSampleTime >= 0.0 && Now < NextSampleTime - 0.25 * SampleInterval)
+	{
+		return;
+	}
+
+	// Keep the schedule instead of restarting it from now, unless a hitch left it more than a sample behind
+	NextSampleTime = NextSampleTime >= 0.0 && Now - NextSampleTime < SampleInterval ? NextSampleTime + SampleInterval : Now + SampleInterval;
+
+	SCOPE_CYCLE_COUNTER(STAT_ARPGLagCompensation_Record);
+
+	// Characters stay registered until EndPlay, stale entries only happen if that was skipped
+	TArrayView<FVector3f> FrameLocations = History.AddFrame(Now);
+	for (int32 Slot = 0; Slot < SlotCharacters.Num(); ++Slot)
+	{
+		if (const ACharacter* Character = SlotCharacters[Slot].Get())
+		{
+			FrameLocations[Slot] = FVector3f(Character->GetCapsuleComponent()->GetComponentLocation());
+		}
+	}
+}
+
+TStatId UARPGLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGLagCompensationSubsystem, STATGROUP_Tickables);
+}
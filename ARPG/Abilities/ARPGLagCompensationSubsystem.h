@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ARPGWeaponTraceTypes.h"
+#include "ARPGLagCompensationSubsystem.generated.h"
+
+class ACharacter;
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_ARPGLagCompensation_Record, STATGROUP_ARPGAnimNotifications);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Query"), STAT_ARPGLagCompensation_Query, STATGROUP_ARPGAnimNotifications);
+
+/**
+ * Ring buffer of recent capsule locations for a set of slots (one slot per character).
+ *
+ * Locations are stored frame-major: all slots of a frame are contiguous, so rewinding every character to a point in time
+ * walks two contiguous arrays. Capsule sizes never change and are stored once per slot.
+ * Plain struct with no world dependency so it can be benchmarked on its own.
+ */
+struct ARPG_API FARPGCapsuleHistory
+{
+	/** A capsule found by QuerySegment */
+	struct FSegmentHit
+	{
+		int32 Slot = INDEX_NONE;
+		FVector Center = FVector::ZeroVector;
+		float Distance = 0.f;
+	};
+
+	/** Clears all history and slots and sets how many frames are kept */
+	void Configure(int32 InFrameCapacity);
+
+	/** Adds a slot for a capsule with the given size. History for the slot starts at the next recorded frame. */
+	int32 AddSlot(float Radius, float HalfHeight);
+
+	/** Frees a slot so it can be reused */
+	void RemoveSlot(int32 Slot);
+
+	/**
+	 * Starts a new frame, overwriting the oldest one once the buffer is full.
+	 * Returns the locations of the frame, indexed by slot, to be filled by the caller.
+	 */
+	TArrayView<FVector3f> AddFrame(double Time);
+
+	/** Location of the slot's capsule at the given time, interpolated between the recorded frames around it. Clamped to the recorded range. */
+	bool GetLocationAtTime(int32 Slot, double Time, FVector& OutLocation) const;
+
+	/** Finds every capsule a segment with the given radius touched at the given time */
+	void QuerySegment(double Time, const FVector& Start, const FVector& End, float Radius, TArray<FSegmentHit>& OutHits) const;
+
+	float GetSlotRadius(int32 Slot) const { return SlotRadii[Slot]; }
+	float GetSlotHalfHeight(int32 Slot) const { return SlotHalfHeights[Slot]; }
+	int32 GetNumFrames() const { return NumFrames; }
+	int32 GetSlotCapacity() const { return SlotCapacity; }
+
+private:
+	/** Finds the two frames (as physical indices) around Time and the blend between them. False if there are no frames. */
+	bool FindFrames(double Time, int32& OutFrameA, int32& OutFrameB, float& OutAlpha) const;
+
+	/** Physical frame index of the Nth oldest frame */
+	int32 GetFrameIndex(int32 LogicalIndex) const { return (OldestFrame + LogicalIndex) % FrameCapacity; }
+
+	/** Grows the number of slots per frame, keeping the recorded history */
+	void GrowSlots(int32 NewSlotCapacity);
+
+	/** Clamps a time to the part of the history where Slot was valid */
+	double ClampToSlotHistory(int32 Slot, double Time) const;
+
+	int32 FrameCapacity = 0;
+	int32 SlotCapacity = 0;
+	int32 OldestFrame = 0;
+	int32 NumFrames = 0;
+
+	/** Recording time of each frame */
+	TArray<double> FrameTimes;
+
+	/** FrameCapacity * SlotCapacity locations, frame-major */
+	TArray<FVector3f> Locations;
+
+	/** Per slot data */
+	TArray<float> SlotRadii;
+	TArray<float> SlotHalfHeights;
+	TArray<double> SlotFirstTimes;
+	TBitArray<> ActiveSlots;
+	TArray<int32> FreeSlots;
+};
+
+/**
+ * Server-side lag compensation. Records the capsule location of every registered character a fixed number of times per second
+ * (ARPG.LagComp.SampleRate), keeping ARPG.LagComp.HistoryMs of history, and lets hit validation rewind characters to the
+ * time a client saw them.
+ */
+UCLASS()
+class ARPG_API UARPGLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** A character found by QueryCapsulesAlongSegment */
+	struct FRewoundHit
+	{
+		AActor* Actor = nullptr;
+		FVector Center = FVector::ZeroVector;
+		float Distance = 0.f;
+	};
+
+	/** Returns the lag compensation subsystem of the world the context object lives in */
+	static UARPGLagCompensationSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Server only - Starts recording the capsule of the given character */
+	void RegisterCharacter(ACharacter* Character);
+
+	/** Stops recording the capsule of the given character */
+	void UnregisterCharacter(ACharacter* Character);
+
+	/**
+	 * Returns where the capsule of Actor was at the given server time. False if the actor isn't recorded.
+	 */
+	bool GetRewoundCapsule(const AActor* Actor, double ServerTime, FVector& OutCenter, float& OutRadius, float& OutHalfHeight) const;
+
+	/**
+	 * Rewinds every recorded character to the given server time and returns the ones a segment with the given radius touched.
+	 * Meant for validating weapon traces and projectiles.
+	 */
+	void QueryCapsulesAlongSegment(double ServerTime, const FVector& Start, const FVector& End, float Radius, TArray<FRewoundHit>& OutHits, const AActor* IgnoreActor = nullptr) const;
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	/** Rebuilds the history if the history length or sample rate changed */
+	void ApplySettings();
+
+	FARPGCapsuleHistory History;
+
+	/** Character recorded in each slot */
+	TArray<TWeakObjectPtr<ACharacter>> SlotCharacters;
+
+	/** Slot of each recorded character */
+	TMap<TObjectKey<AActor>, int32> CharacterSlots;
+
+	/** Settings the history was built with */
+	int32 AppliedHistoryMs = 0;
+	float AppliedSampleRate = 0.f;
+
+	/** World time at which the next frame is due, advanced by whole sample intervals. Negative to sample right away. */
+	double NextSampleTime = -1.0;
+
+	/** Scratch buffer for queries */
+	mutable TArray<FARPGCapsuleHistory::FSegmentHit> QueryScratch;
+};
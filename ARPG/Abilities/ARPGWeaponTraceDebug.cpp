@@ -0,0 +1,193 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGWeaponTraceDebug.h"
+
+#if ARPG_WEAPON_TRACE_DEBUG
+
+#include "HAL/IConsoleManager.h"
+#include "DrawDebugHelpers.h"
+#include "CollisionShape.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Logging/StructuredLog.h"
+#include "ARPG/ARPG.h"
+
+namespace ARPGWeaponTraceDebug
+{
+	int32 GMode = 0;
+	static FAutoConsoleVariableRef CVarMode(
+		TEXT("ARPG.WeaponTrace.Debug"),
+		GMode,
+		TEXT("Weapon trace visualizer. 0: off, 1: draw live, 2: record to a ring buffer (see ARPG.WeaponTrace.Debug.Replay)."),
+		ECVF_Cheat);
+
+	static float GDrawDuration = 2.f;
+	static FAutoConsoleVariableRef CVarDrawDuration(
+		TEXT("ARPG.WeaponTrace.Debug.DrawDuration"),
+		GDrawDuration,
+		TEXT("Seconds live weapon trace debug shapes stay on screen."),
+		ECVF_Cheat);
+
+	static int32 GBufferSize = 2048;
+	static FAutoConsoleVariableRef CVarBufferSize(
+		TEXT("ARPG.WeaponTrace.Debug.BufferSize"),
+		GBufferSize,
+		TEXT("Number of sweeps and hits kept by the weapon trace recorder. Applies the next time the buffer is cleared."),
+		ECVF_Cheat);
+
+	/** One recorded sweep or hit */
+	struct FRecordedEntry
+	{
+		double WorldTime = 0.0;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		FQuat Rotation = FQuat::Identity;
+		FVector Extent = FVector::ZeroVector;
+		bool bHit = false;
+	};
+
+	/** Fixed size ring buffer of the most recent entries, allocated on first use */
+	struct FRecorder
+	{
+		TArray<FRecordedEntry> Entries;
+		int32 NextIndex = 0;
+		int32 Num = 0;
+
+		void Add(const FRecordedEntry& Entry)
+		{
+			if (Entries.Num() == 0)
+			{
+				Entries.SetNum(FMath::Max(1, GBufferSize));
+			}
+
+			Entries[NextIndex] = Entry;
+			NextIndex = (NextIndex + 1) % Entries.Num();
+			Num = FMath::Min(Num + 1, Entries.Num());
+		}
+
+		void Clear()
+		{
+			Entries.Empty();
+			NextIndex = 0;
+			Num = 0;
+		}
+
+		/** Calls Visitor for every entry, oldest first */
+		template <typename FunctorType>
+		void ForEach(FunctorType&& Visitor) const
+		{
+			const int32 First = (NextIndex - Num + Entries.Num()) % FMath::Max(1, Entries.Num());
+			for (int32 Offset = 0; Offset < Num; ++Offset)
+			{
+				Visitor(Entries[(First + Offset) % Entries.Num()]);
+			}
+		}
+	};
+
+	static FRecorder Recorder;
+
+	static void DrawEntry(const UWorld* World, const FRecordedEntry& Entry, float Duration)
+	{
+		if (Entry.bHit)
+		{
+			DrawDebugBox(World, Entry.Start, Entry.Extent, FColor::Green, false, Duration, 0, 1.f);
+			return;
+		}
+
+		// A box swept along the blade: the box at both ends and the path between them
+		DrawDebugBox(World, Entry.Start, Entry.Extent, Entry.Rotation, FColor::Yellow, false, Duration, 0, 0.5f);
+		DrawDebugBox(World, Entry.End, Entry.Extent, Entry.Rotation, FColor::Yellow, false, Duration, 0, 0.5f);
+		DrawDebugLine(World, Entry.Start, Entry.End, FColor::Red, false, Duration, 0, 1.f);
+	}
+
+	static void AddEntry(const UWorld* World, const FRecordedEntry& Entry)
+	{
+		if (GMode == static_cast<int32>(EMode::Record))
+		{
+			Recorder.Add(Entry);
+		}
+		else if (GMode == static_cast<int32>(EMode::Draw))
+		{
+			DrawEntry(World, Entry, GDrawDuration);
+		}
+	}
+
+	void AddSweep(const UWorld* World, const FARPGWeaponBladePose& Pose, const FCollisionShape& Shape)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		FRecordedEntry Entry;
+		Entry.WorldTime = World->GetTimeSeconds();
+		Entry.Start = Pose.Start;
+		Entry.End = Pose.End;
+		Entry.Rotation = Pose.Rotation;
+		Entry.Extent = Shape.GetExtent();
+		AddEntry(World, Entry);
+	}
+
+	void AddHit(const UWorld* World, const AActor* HitActor)
+	{
+		if (!World || !HitActor)
+		{
+			return;
+		}
+
+		FVector Origin;
+		FVector Extent;
+		HitActor->GetActorBounds(/* bOnlyCollidingComponents = */ true, Origin, Extent);
+
+		FRecordedEntry Entry;
+		Entry.WorldTime = World->GetTimeSeconds();
+		Entry.Start = Origin;
+		Entry.End = Origin;
+		Entry.Extent = Extent;
+		Entry.bHit = true;
+		AddEntry(World, Entry);
+	}
+
+	/**
+	 * Draws the recorded weapon traces.
+	 * Usage: ARPG.WeaponTrace.Debug.Replay [Duration=10] [LastSeconds=0 (everything)]
+	 */
+	static void Replay(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		const float Duration = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.f;
+		const double LastSeconds = Args.Num() > 1 ? FCString::Atod(*Args[1]) : 0.0;
+		const double MinTime = LastSeconds > 0.0 ? World->GetTimeSeconds() - LastSeconds : -UE_DOUBLE_BIG_NUMBER;
+
+		int32 NumDrawn = 0;
+		Recorder.ForEach([&](const FRecordedEntry& Entry)
+			{
+				if (Entry.WorldTime >= MinTime)
+				{
+					DrawEntry(World, Entry, Duration);
+					++NumDrawn;
+				}
+			});
+
+		UE_LOGFMT(LogARPG, Display, "ARPG.WeaponTrace.Debug.Replay: drew {0} of {1} recorded weapon trace entries.", NumDrawn, Recorder.Num);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ReplayCommand(
+		TEXT("ARPG.WeaponTrace.Debug.Replay"),
+		TEXT("Draws the weapon traces recorded while ARPG.WeaponTrace.Debug was 2. Usage: ARPG.WeaponTrace.Debug.Replay [Duration=10] [LastSeconds=0]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Replay),
+		ECVF_Cheat);
+
+	static FAutoConsoleCommand ClearCommand(
+		TEXT("ARPG.WeaponTrace.Debug.Clear"),
+		TEXT("Clears the weapon trace recording."),
+		FConsoleCommandDelegate::CreateLambda([]() { Recorder.Clear(); }),
+		ECVF_Cheat);
+}
+
+#endif // ARPG_WEAPON_TRACE_DEBUG
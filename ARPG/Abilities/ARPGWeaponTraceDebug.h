@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ARPGWeaponTraceTypes.h"
+
+struct FCollisionShape;
+
+/** Weapon trace visualization is compiled out of Shipping builds and builds without debug drawing */
+#define ARPG_WEAPON_TRACE_DEBUG (ENABLE_DRAW_DEBUG && !UE_BUILD_SHIPPING)
+
+#if ARPG_WEAPON_TRACE_DEBUG
+
+/**
+ * Weapon trace visualizer, controlled by ARPG.WeaponTrace.Debug:
+ *	0 - Off. Costs one integer compare per sweep.
+ *	1 - Draw sweeps and hits live.
+ *	2 - Record sweeps and hits into a ring buffer instead of drawing them. Use ARPG.WeaponTrace.Debug.Replay to draw the recording.
+ */
+namespace ARPGWeaponTraceDebug
+{
+	enum class EMode : int32
+	{
+		Off = 0,
+		Draw = 1,
+		Record = 2,
+	};
+
+	/** Current value of ARPG.WeaponTrace.Debug */
+	extern ARPG_API int32 GMode;
+
+	/** Draws or records one blade sweep */
+	ARPG_API void AddSweep(const UWorld* World, const FARPGWeaponBladePose& Pose, const FCollisionShape& Shape);
+
+	/** Draws or records a hit against an actor */
+	ARPG_API void AddHit(const UWorld* World, const AActor* HitActor);
+}
+
+// Statement-like, so they are safe in unbraced if/else and take a semicolon the same way in every build
+#define ARPG_WEAPON_TRACE_DEBUG_SWEEP(World, Pose, Shape) \
+	do { if (ARPGWeaponTraceDebug::GMode != 0) { ARPGWeaponTraceDebug::AddSweep(World, Pose, Shape); } } while (0)
+
+#define ARPG_WEAPON_TRACE_DEBUG_HIT(World, HitActor) \
+	do { if (ARPGWeaponTraceDebug::GMode != 0) { ARPGWeaponTraceDebug::AddHit(World, HitActor); } } while (0)
+
+#else
+
+#define ARPG_WEAPON_TRACE_DEBUG_SWEEP(World, Pose, Shape) do {} while (0)
+#define ARPG_WEAPON_TRACE_DEBUG_HIT(World, HitActor) do {} while (0)
+
+#endif // ARPG_WEAPON_TRACE_DEBUG
@@ -0,0 +1,492 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGWeaponTraceSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Logging/StructuredLog.h"
+#include "AbilitySystemGlobals.h"
+#include "ARPGAnimNotifyStateWeaponTrace.h"
+#include "ARPGLagCompensationSubsystem.h"
+#include "ARPG/Core/ARPGCharacter.h"
+
+namespace ARPGWeaponTrace
+{
+	static TAutoConsoleVariable<bool> CVarAsyncWeaponTrace(
+		TEXT("ARPG.WeaponTrace.Async"),
+		false,
+		TEXT("If true, weapon traces are requested through the async trace API and their hits are processed one frame later. Applies to swings that start after the change."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<bool> CVarClientHitClaims(
+		TEXT("ARPG.WeaponTrace.ClientHitClaims"),
+		true,
+		TEXT("If true, the server doesn't sweep for characters controlled by remote clients and validates the hits they claim instead."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarClaimMaxAge(
+		TEXT("ARPG.WeaponTrace.ClaimMaxAge"),
+		0.5f,
+		TEXT("Maximum age in seconds of a hit claim when it reaches the server. Also how long a swing stays claimable after it ended on the server."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarClaimMaxReach(
+		TEXT("ARPG.WeaponTrace.ClaimMaxReach"),
+		400.f,
+		TEXT("Maximum distance between the attacking character and the blade of a hit claim."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarClaimTolerance(
+		TEXT("ARPG.WeaponTrace.ClaimTolerance"),
+		30.f,
+		TEXT("Extra distance allowed between the claimed blade pose and the target, on top of the blade and target sizes."),
+		ECVF_Default);
+
+	/** Claims beyond this count in a single RPC are ignored */
+	static constexpr int32 MaxClaimsPerBatch = 32;
+
+	/** Capsule of the target in world space. Non-character targets are approximated from their bounds. */
+	static void GetTargetCapsule(const AActor* Target, FVector& OutCenter, float& OutRadius, float& OutHalfHeight)
+	{
+		if (const ACharacter* TargetCharacter = Cast<ACharacter>(Target))
+		{
+			const UCapsuleComponent* Capsule = TargetCharacter->GetCapsuleComponent();
+			OutCenter = Capsule->GetComponentLocation();
+			OutRadius = Capsule->GetScaledCapsuleRadius();
+			OutHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+			return;
+		}
+
+		FVector Extent;
+		Target->GetActorBounds(/* bOnlyCollidingComponents = */ true, OutCenter, Extent);
+		OutRadius = Extent.Size2D();
+		OutHalfHeight = FMath::Max(Extent.Z, OutRadius);
+	}
+}
+
+void FARPGWeaponTraceState::Reset()
+{
+	Character.Reset();
+	WeaponMesh.Reset();
+	Notify.Reset();
+	CollisionObjectQueryParams = FCollisionObjectQueryParams();
+	CollisionQueryParams = FCollisionQueryParams();
+	HitRecords.Reset();
+	BladeSocketsMesh.Reset();
+	LocalBladeStart = FVector::ZeroVector;
+	LocalBladeEnd = FVector::ZeroVector;
+	LocalBladeRotation = FQuat::Identity;
+	PreviousBladePose = FARPGWeaponBladePose();
+	SwingId = 0;
+	ClaimSwingId = 0;
+	NumPendingAsyncSweeps = 0;
+	bHasSweptPreviousPose = false;
+	bAsync = false;
+	bQueuedForProcessing = false;
+	bReleasePending = false;
+	bServerValidatesClaims = false;
+	ReleaseTime = 0.0;
+	HitResults.Reset();
+	StepHitResults.Reset();
+}
+
+UARPGWeaponTraceSubsystem* UARPGWeaponTraceSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGWeaponTraceSubsystem>() : nullptr;
+}
+
+bool UARPGWeaponTraceSubsystem::IsAsyncTraceEnabled()
+{
+	return ARPGWeaponTrace::CVarAsyncWeaponTrace.GetValueOnGameThread();
+}
+
+bool UARPGWeaponTraceSubsystem::AreClientHitClaimsEnabled()
+{
+	return ARPGWeaponTrace::CVarClientHitClaims.GetValueOnGameThread();
+}
+
+float UARPGWeaponTraceSubsystem::GetClaimGraceSeconds()
+{
+	return ARPGWeaponTrace::CVarClaimMaxAge.GetValueOnGameThread();
+}
+
+void UARPGWeaponTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	AsyncSweepDelegate.BindUObject(this, &UARPGWeaponTraceSubsystem::OnAsyncSweepCompleted);
+}
+
+void UARPGWeaponTraceSubsystem::Deinitialize()
+{
+	AsyncSweepDelegate.Unbind();
+
+	ActiveStates.Empty();
+	StatesBySwingId.Empty();
+	StatesToProcess.Empty();
+	ReleasedStates.Empty();
+	FreeStates.Empty();
+	AllStates.Empty();
+
+	SET_DWORD_STAT(STAT_ARPGWeaponTrace_ActiveStates, 0);
+	SET_DWORD_STAT(STAT_ARPGWeaponTrace_PooledStates, 0);
+
+	Super::Deinitialize();
+}
+
+FARPGWeaponTraceState& UARPGWeaponTraceSubsystem::AcquireState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent)
+{
+	const FStateKey Key(MeshComp, NotifyEvent);
+
+	FARPGWeaponTraceState* State = nullptr;
+	if (FARPGWeaponTraceState* const* ExistingState = ActiveStates.Find(Key))
+	{
+		// Restarted without ending. Sweeps still in flight for the old swing are dropped since its swing id goes away.
+		State = *ExistingState;
+		StatesBySwingId.Remove(State->SwingId);
+		State->Reset();
+	}
+	else
+	{
+		if (FreeStates.Num() > 0)
+		{
+			State = FreeStates.Pop(EAllowShrinking::No);
+		}
+		else
+		{
+			State = AllStates.Add_GetRef(MakeUnique<FARPGWeaponTraceState>()).Get();
+			FreeStates.Reserve(AllStates.Num());
+		}
+
+		ActiveStates.Add(Key, State);
+	}
+
+	// Zero is never used so a reset state can't match anything
+	if (++LastSwingId == 0)
+	{
+		++LastSwingId;
+	}
+
+	State->SwingId = LastSwingId;
+	State->bAsync = IsAsyncTraceEnabled();
+	StatesBySwingId.Add(State->SwingId, State);
+
+	SET_DWORD_STAT(STAT_ARPGWeaponTrace_ActiveStates, ActiveStates.Num());
+	SET_DWORD_STAT(STAT_ARPGWeaponTrace_PooledStates, AllStates.Num());
+
+	return *State;
+}
+
+FARPGWeaponTraceState* UARPGWeaponTraceSubsystem::FindState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent) const
+{
+	FARPGWeaponTraceState* const* State = ActiveStates.Find(FStateKey(MeshComp, NotifyEvent));
+	return State ? *State : nullptr;
+}
+
+void UARPGWeaponTraceSubsystem::ReleaseState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent, float Delay)
+{
+	FARPGWeaponTraceState* State = nullptr;
+	if (!ActiveStates.RemoveAndCopyValue(FStateKey(MeshComp, NotifyEvent), State))
+	{
+		return;
+	}
+
+	SET_DWORD_STAT(STAT_ARPGWeaponTrace_ActiveStates, ActiveStates.Num());
+
+	// Hits of the last sweeps of the swing are still on their way, or late hit claims may still arrive.
+	// Keep the state around until then.
+	if (Delay > 0.f || State->NumPendingAsyncSweeps > 0 || State->bQueuedForProcessing)
+	{
+		State->bReleasePending = true;
+		State->ReleaseTime = GetWorld()->GetTimeSeconds() + Delay;
+		ReleasedStates.Add(State);
+		return;
+	}
+
+	RecycleState(State);
+}
+
+void UARPGWeaponTraceSubsystem::HandleHitClaims(AARPGCharacter* Character, const TArray<FARPGWeaponHitClaim>& Claims)
+{
+	if (!Character || !Character->HasAuthority() || !AreClientHitClaimsEnabled())
+	{
+		return;
+	}
+
+	const int32 NumClaims = FMath::Min(Claims.Num(), ARPGWeaponTrace::MaxClaimsPerBatch);
+	INC_DWORD_STAT_BY(STAT_ARPGWeaponTrace_ClaimsRejected, Claims.Num() - NumClaims);
+
+	// A batch holds the hits of one sweep, so usually of one swing, but a swing may end and the next begin in between
+	int32 BatchStart = 0;
+	while (BatchStart < NumClaims)
+	{
+		const uint32 ClaimSwingId = Claims[BatchStart].SwingId;
+		int32 BatchEnd = BatchStart + 1;
+		while (BatchEnd < NumClaims && Claims[BatchEnd].SwingId == ClaimSwingId)
+		{
+			++BatchEnd;
+		}
+
+		// Claims must match an open swing of this character exactly, they are never attributed to another swing
+		FARPGWeaponTraceState* State = FindClaimableState(Character, ClaimSwingId);
+		const UARPGAnimNotifyStateWeaponTrace* Notify = State ? State->Notify.Get() : nullptr;
+		if (!Notify)
+		{
+			UE_LOGFMT(LogTemp, Verbose, "Dropped {0} weapon hit claims from {1}, it has no open swing {2}.", BatchEnd - BatchStart, Character->GetName(), ClaimSwingId);
+			INC_DWORD_STAT_BY(STAT_ARPGWeaponTrace_ClaimsRejected, BatchEnd - BatchStart);
+			BatchStart = BatchEnd;
+			continue;
+		}
+
+		TArray<FARPGWeaponTraceHitCandidate, TInlineAllocator<8>> Candidates;
+		for (int32 Index = BatchStart; Index < BatchEnd; ++Index)
+		{
+			FARPGWeaponTraceHitCandidate Candidate;
+			if (ValidateHitClaim(*State, Character, Claims[Index], Candidate))
+			{
+				Candidates.Add(Candidate);
+			}
+		}
+
+		INC_DWORD_STAT_BY(STAT_ARPGWeaponTrace_ClaimsAccepted, Candidates.Num());
+		INC_DWORD_STAT_BY(STAT_ARPGWeaponTrace_ClaimsRejected, (BatchEnd - BatchStart) - Candidates.Num());
+
+		// Hit events may end the swing and recycle its state, the next batch looks its swing up again
+		if (Candidates.Num() > 0)
+		{
+			Notify->ProcessHitCandidates(*State, Candidates);
+		}
+
+		BatchStart = BatchEnd;
+	}
+}
+
+FARPGWeaponTraceState* UARPGWeaponTraceSubsystem::FindClaimableState(const AARPGCharacter* Character, uint32 ClaimSwingId) const
+{
+	// Only a handful of swings are active at once, a linear search is fine
+	const double Now = GetWorld()->GetTimeSeconds();
+	FARPGWeaponTraceState* EndedState = nullptr;
+	for (const TPair<uint32, FARPGWeaponTraceState*>& Pair : StatesBySwingId)
+	{
+		FARPGWeaponTraceState* State = Pair.Value;
+		if (!State->bServerValidatesClaims || State->ClaimSwingId != ClaimSwingId || State->Character.Get() != Character)
+		{
+			continue;
+		}
+
+		// The same attack played twice in a row has the same id, the swing in progress wins over the one that ended
+		if (!State->bReleasePending)
+		{
+			return State;
+		}
+
+		if (Now <= State->ReleaseTime)
+		{
+			EndedState = State;
+		}
+	}
+
+	return EndedState;
+}
+
+bool UARPGWeaponTraceSubsystem::ValidateHitClaim(const FARPGWeaponTraceState& State, const AARPGCharacter* Character, const FARPGWeaponHitClaim& Claim, FARPGWeaponTraceHitCandidate& OutCandidate) const
+{
+	AActor* Target = Claim.Target;
+	if (!IsValid(Target) || Target == Character)
+	{
+		return false;
+	}
+
+	UAbilitySystemComponent* TargetASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Target);
+	if (!TargetASC)
+	{
+		return false;
+	}
+
+	// The claim must be recent, and can't come from the future (allowing for clock sync error)
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	const double ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	const double ClaimAge = ServerTime - Claim.ServerTime;
+	const float MaxAge = ARPGWeaponTrace::CVarClaimMaxAge.GetValueOnGameThread();
+	if (ClaimAge > MaxAge || ClaimAge < -0.1)
+	{
+		UE_LOGFMT(LogTemp, Verbose, "Rejected weapon hit claim from {0} on {1}: claim is {2}s old.", Character->GetName(), Target->GetName(), ClaimAge);
+		return false;
+	}
+
+	// Everyone may have moved since the hit happened
+	const double Age = FMath::Max(ClaimAge, 0.0);
+	const float Tolerance = ARPGWeaponTrace::CVarClaimTolerance.GetValueOnGameThread();
+
+	// The blade has to be within reach of the attacker
+	const FVector AttackerLocation = Character->GetActorLocation();
+	const double MaxReach = ARPGWeaponTrace::CVarClaimMaxReach.GetValueOnGameThread() + Character->GetVelocity().Size() * Age + Tolerance;
+	if (FVector::DistSquared(AttackerLocation, Claim.BladeStart) > FMath::Square(MaxReach) || FVector::DistSquared(AttackerLocation, Claim.BladeEnd) > FMath::Square(MaxReach))
+	{
+		UE_LOGFMT(LogTemp, Verbose, "Rejected weapon hit claim from {0} on {1}: blade is out of reach.", Character->GetName(), Target->GetName());
+		return false;
+	}
+
+	// The blade has to touch the target's capsule where the attacker saw it. Other characters are displayed about half a
+	// round trip behind the server, so rewind to that. Targets without history fall back to their current capsule plus
+	// however far they could have moved since.
+	FVector CapsuleCenter;
+	float CapsuleRadius = 0.f;
+	float CapsuleHalfHeight = 0.f;
+	double TargetMovementSlack = 0.0;
+
+	const APlayerState* AttackerPlayerState = Character->GetPlayerState();
+	const double HalfRoundTrip = AttackerPlayerState ? AttackerPlayerState->GetPingInMilliseconds() * 0.0005 : 0.0;
+	const UARPGLagCompensationSubsystem* LagCompensation = UARPGLagCompensationSubsystem::Get(this);
+	if (!LagCompensation || !LagCompensation->GetRewoundCapsule(Target, Claim.ServerTime - HalfRoundTrip, CapsuleCenter, CapsuleRadius, CapsuleHalfHeight))
+	{
+		ARPGWeaponTrace::GetTargetCapsule(Target, CapsuleCenter, CapsuleRadius, CapsuleHalfHeight);
+		TargetMovementSlack = Target->GetVelocity().Size() * (Age + HalfRoundTrip);
+	}
+
+	const FVector CapsuleAxis = FVector::UpVector * FMath::Max(CapsuleHalfHeight - CapsuleRadius, 0.f);
+	FVector ClosestOnBlade;
+	FVector ClosestOnCapsule;
+	FMath::SegmentDistToSegmentSafe(Claim.BladeStart, Claim.BladeEnd, CapsuleCenter - CapsuleAxis, CapsuleCenter + CapsuleAxis, ClosestOnBlade, ClosestOnCapsule);
+
+	const FVector BladeExtent = State.WeaponTraceShape.GetExtent();
+	const double BladeThickness = FMath::Max(BladeExtent.X, BladeExtent.Y);
+	const double MaxDistance = CapsuleRadius + BladeThickness + TargetMovementSlack + Tolerance;
+	if (FVector::DistSquared(ClosestOnBlade, ClosestOnCapsule) > FMath::Square(MaxDistance))
+	{
+		UE_LOGFMT(LogTemp, Verbose, "Rejected weapon hit claim from {0} on {1}: blade doesn't touch the target.", Character->GetName(), Target->GetName());
+		return false;
+	}
+
+	OutCandidate.Actor = Target;
+	OutCandidate.AbilitySystem = TargetASC;
+	OutCandidate.BladeStart = Claim.BladeStart;
+	OutCandidate.BladeEnd = Claim.BladeEnd;
+	return true;
+}
+
+void UARPGWeaponTraceSubsystem::RequestAsyncSweep(UWorld* World, FARPGWeaponTraceState& State, const FARPGWeaponBladePose& Pose)
+{
+	check(World);
+
+	World->AsyncSweepByObjectType(
+		EAsyncTraceType::Multi,
+		Pose.Start,
+		Pose.End,
+		Pose.Rotation,
+		State.CollisionObjectQueryParams,
+		State.WeaponTraceShape,
+		State.CollisionQueryParams,
+		&AsyncSweepDelegate,
+		State.SwingId
+	);
+
+	++State.NumPendingAsyncSweeps;
+	INC_DWORD_STAT(STAT_ARPGWeaponTrace_AsyncSweeps);
+}
+
+void UARPGWeaponTraceSubsystem::OnAsyncSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FARPGWeaponTraceState* State = StatesBySwingId.FindRef(TraceDatum.UserData);
+	if (!State)
+	{
+		// The swing was restarted or its state was recycled
+		return;
+	}
+
+	--State->NumPendingAsyncSweeps;
+	State->HitResults.Append(TraceDatum.OutHits);
+
+	if (!State->bQueuedForProcessing)
+	{
+		State->bQueuedForProcessing = true;
+		StatesToProcess.Add(State);
+	}
+}
+
+void UARPGWeaponTraceSubsystem::ProcessAsyncResults()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGWeaponTrace_ProcessAsyncResults);
+
+	// Hit events may start or end swings, which can queue more states. Those are handled next tick.
+	TArray<FARPGWeaponTraceState*> States = MoveTemp(StatesToProcess);
+	StatesToProcess.Reset();
+
+	for (FARPGWeaponTraceState* State : States)
+	{
+		if (!State->bQueuedForProcessing)
+		{
+			// Reset since it was queued
+			continue;
+		}
+
+		State->bQueuedForProcessing = false;
+
+		if (const UARPGAnimNotifyStateWeaponTrace* Notify = State->Notify.Get())
+		{
+			Notify->ProcessHitResults(*State);
+		}
+
+		// Processing the hits may have recycled the state already, in which case it no longer has a swing id
+		if (State->SwingId == 0)
+		{
+			continue;
+		}
+
+		State->HitResults.Reset();
+	}
+
+	// Hand the allocation back, unless processing queued more states
+	if (StatesToProcess.Num() == 0)
+	{
+		States.Reset();
+		StatesToProcess = MoveTemp(States);
+	}
+}
+
+void UARPGWeaponTraceSubsystem::RecycleReleasedStates()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = ReleasedStates.Num() - 1; Index >= 0; --Index)
+	{
+		FARPGWeaponTraceState* State = ReleasedStates[Index];
+		if (Now >= State->ReleaseTime && State->NumPendingAsyncSweeps <= 0 && !State->bQueuedForProcessing)
+		{
+			ReleasedStates.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			RecycleState(State);
+		}
+	}
+}
+
+void UARPGWeaponTraceSubsystem::RecycleState(FARPGWeaponTraceState* State)
+{
+	StatesBySwingId.Remove(State->SwingId);
+	State->Reset();
+	FreeStates.Add(State);
+}
+
+void UARPGWeaponTraceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (StatesToProcess.Num() > 0)
+	{
+		ProcessAsyncResults();
+	}
+
+	if (ReleasedStates.Num() > 0)
+	{
+		RecycleReleasedStates();
+	}
+}
+
+TStatId UARPGWeaponTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGWeaponTraceSubsystem, STATGROUP_Tickables);
+}
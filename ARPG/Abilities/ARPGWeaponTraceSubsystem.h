@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CollisionQueryParams.h"
+#include "CollisionShape.h"
+#include "WorldCollision.h"
+#include "Engine/HitResult.h"
+#include "Engine/NetSerialization.h"
+#include "ARPGWeaponTraceTypes.h"
+#include "ARPGWeaponTraceSubsystem.generated.h"
+
+class AARPGCharacter;
+class ACharacter;
+class UARPGAnimNotifyStateWeaponTrace;
+class UStaticMesh;
+class UStaticMeshComponent;
+class USkeletalMeshComponent;
+struct FAnimNotifyEvent;
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Trace Process Async Results"), STAT_ARPGWeaponTrace_ProcessAsyncResults, STATGROUP_ARPGAnimNotifications);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Trace Active States"), STAT_ARPGWeaponTrace_ActiveStates, STATGROUP_ARPGAnimNotifications);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Trace Pooled States"), STAT_ARPGWeaponTrace_PooledStates, STATGROUP_ARPGAnimNotifications);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Trace Async Sweeps"), STAT_ARPGWeaponTrace_AsyncSweeps, STATGROUP_ARPGAnimNotifications);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Trace Hit Claims Accepted"), STAT_ARPGWeaponTrace_ClaimsAccepted, STATGROUP_ARPGAnimNotifications);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Trace Hit Claims Rejected"), STAT_ARPGWeaponTrace_ClaimsRejected, STATGROUP_ARPGAnimNotifications);
+
+/**
+ * A hit found by the weapon trace of a locally controlled client, sent to the server for validation.
+ */
+USTRUCT()
+struct FARPGWeaponHitClaim
+{
+	GENERATED_BODY()
+
+	/** Id of the swing the hit belongs to, computed the same way on client and server. See FARPGWeaponTraceState::ClaimSwingId */
+	UPROPERTY()
+	uint32 SwingId = 0;
+
+	/** The actor the client hit */
+	UPROPERTY()
+	TObjectPtr<AActor> Target;
+
+	/** Server world time (as estimated by the client) at which the hit happened */
+	UPROPERTY()
+	float ServerTime = 0.f;
+
+	/** Blade pose of the sweep that found the hit */
+	UPROPERTY()
+	FVector_NetQuantize BladeStart;
+
+	UPROPERTY()
+	FVector_NetQuantize BladeEnd;
+};
+
+/**
+ * An actor hit during a swing, with enough history to apply the notify's multi-hit rules.
+ */
+struct FARPGWeaponTraceHitRecord
+{
+	TObjectKey<AActor> Actor;
+
+	/** Number of hits on the actor accepted during the swing */
+	int32 NumHits = 0;
+
+	/** World time of the last accepted hit */
+	double LastHitTime = 0.0;
+};
+
+/**
+ * State of a single weapon trace, i.e. one character swinging through one weapon trace notify.
+ * Notify objects are shared by everyone playing the same animation, so anything that changes during a swing lives here.
+ */
+struct FARPGWeaponTraceState
+{
+	/** The character executing the animation montage, a player or an enemy */
+	TWeakObjectPtr<ACharacter> Character;
+
+	/** The weapon mesh of the character */
+	TWeakObjectPtr<UStaticMeshComponent> WeaponMesh;
+
+	/** The notify running this swing. Used to process hits that arrive asynchronously. */
+	TWeakObjectPtr<const UARPGAnimNotifyStateWeaponTrace> Notify;
+
+	/** Object types the trace looks for, built from the notify's CollisionObjectTypesToQuery */
+	FCollisionObjectQueryParams CollisionObjectQueryParams;
+
+	/** Further parameters for the collision query, such as ignored actors */
+	FCollisionQueryParams CollisionQueryParams;
+
+	/** The shape of the trace that will be performed */
+	FCollisionShape WeaponTraceShape;
+
+	/** Actors hit during this swing. Swings rarely hit more than a handful of actors, so this stays inline. */
+	TArray<FARPGWeaponTraceHitRecord, TInlineAllocator<8>> HitRecords;
+
+	/** Static mesh the blade sockets below were resolved from. Sockets are resolved again if the weapon mesh changes mid-swing. */
+	TWeakObjectPtr<const UStaticMesh> BladeSocketsMesh;
+
+	/** Blade start, end and rotation relative to the weapon mesh component, taken from the trace sockets when the swing starts */
+	FVector LocalBladeStart = FVector::ZeroVector;
+	FVector LocalBladeEnd = FVector::ZeroVector;
+	FQuat LocalBladeRotation = FQuat::Identity;
+
+	/** Pose of the blade at the end of the last sweep. Sub-steps are interpolated from this pose. */
+	FARPGWeaponBladePose PreviousBladePose;
+
+	/** Unique id of this swing. Async sweep results are matched to their state through it. */
+	uint32 SwingId = 0;
+
+	/**
+	 * Id of this swing shared by the owning client and the server, used to match hit claims to their swing.
+	 * Built from the prediction key of the ability playing the montage and the notify's timing. 0 if no claims are involved.
+	 */
+	uint32 ClaimSwingId = 0;
+
+	/** Async sweeps requested for this swing that haven't returned yet */
+	int32 NumPendingAsyncSweeps = 0;
+
+	/** False until the first sweep of this swing, which also needs to sweep the starting pose */
+	bool bHasSweptPreviousPose = false;
+
+	/** If true, sweeps are requested through the async trace API and their hits are processed the next frame */
+	bool bAsync = false;
+
+	/** True while the state is waiting in the subsystem's queue of states with async hits to process */
+	bool bQueuedForProcessing = false;
+
+	/** The swing ended, the state goes back to the pool once its pending async sweeps have been processed */
+	bool bReleasePending = false;
+
+	/**
+	 * Server only - The swing belongs to a character controlled by a remote client. The server doesn't sweep,
+	 * the client sends its hits as claims which are validated against this state.
+	 */
+	bool bServerValidatesClaims = false;
+
+	/** World time after which a released state may go back to the pool */
+	double ReleaseTime = 0.0;
+
+	/** Hits of the last sweep, or hits received from async sweeps that haven't been processed yet */
+	TArray<FHitResult> HitResults;
+
+	/** Scratch buffer for sweep results, kept with the state so pooled states don't allocate */
+	TArray<FHitResult> StepHitResults;
+
+	/** Clears the state for reuse. Keeps container allocations. */
+	void Reset();
+};
+
+/**
+ * Owns the per-swing state of every active weapon trace in the world.
+ *
+ * States are keyed by the skeletal mesh playing the animation and the notify event being played,
+ * and are recycled through a free list so swings don't allocate once the pool has warmed up.
+ *
+ * When ARPG.WeaponTrace.Async is enabled, weapon sweeps are requested through the world's async trace API
+ * instead of running inside the anim notify tick. Their results are collected here at the start of the next frame
+ * and handed back to the notifies in one batch when the subsystem ticks.
+ */
+UCLASS()
+class ARPG_API UARPGWeaponTraceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the weapon trace subsystem of the world the context object lives in */
+	static UARPGWeaponTraceSubsystem* Get(const UObject* WorldContextObject);
+
+	/** True if newly started swings should use async sweeps. See ARPG.WeaponTrace.Async */
+	static bool IsAsyncTraceEnabled();
+
+	/** True if the server trusts validated hit claims from clients instead of sweeping for them. See ARPG.WeaponTrace.ClientHitClaims */
+	static bool AreClientHitClaimsEnabled();
+
+	/** Seconds a claim-validating swing stays around after it ended, so late claims can still be matched to it */
+	static float GetClaimGraceSeconds();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Returns a reset state for the given mesh and notify event, reusing a pooled state if possible.
+	 * If a state is already active for this key (the notify restarted without ending), it is reset and returned.
+	 * The returned pointer stays valid until the state is released.
+	 */
+	FARPGWeaponTraceState& AcquireState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent);
+
+	/** Returns the active state for the given mesh and notify event, or null if there isn't one */
+	FARPGWeaponTraceState* FindState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent) const;
+
+	/**
+	 * Ends the swing of the given mesh and notify event. The state goes back to the pool once Delay seconds
+	 * have passed and its async sweeps have returned and been processed.
+	 */
+	void ReleaseState(const USkeletalMeshComponent* MeshComp, const FAnimNotifyEvent* NotifyEvent, float Delay = 0.f);
+
+	/**
+	 * Server only - Validates hit claims sent by the client controlling Character and passes the valid ones
+	 * to the notify of the character's current swing. Claims that don't match a swing are dropped.
+	 */
+	void HandleHitClaims(AARPGCharacter* Character, const TArray<FARPGWeaponHitClaim>& Claims);
+
+	/** Requests an async sweep of the blade at the given pose. Hits are processed by the state's notify next frame. */
+	void RequestAsyncSweep(UWorld* World, FARPGWeaponTraceState& State, const FARPGWeaponBladePose& Pose);
+
+	/** Number of states currently in use */
+	int32 GetNumActiveStates() const { return ActiveStates.Num(); }
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	using FStateKey = TPair<TObjectKey<USkeletalMeshComponent>, const FAnimNotifyEvent*>;
+
+	/** Called by the world when an async sweep requested by RequestAsyncSweep finished */
+	void OnAsyncSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Hands the async hits received since the last tick to their notifies */
+	void ProcessAsyncResults();
+
+	/** Puts a state that is no longer used by anything back into the free list */
+	void RecycleState(FARPGWeaponTraceState* State);
+
+	/** Recycles released states whose delay is over and that have no async work left */
+	void RecycleReleasedStates();
+
+	/**
+	 * Returns the swing of a remotely controlled character with the given claim swing id that hit claims should be validated
+	 * against. Swings that ended are only considered during the claim grace period, and after swings still in progress.
+	 */
+	FARPGWeaponTraceState* FindClaimableState(const AARPGCharacter* Character, uint32 ClaimSwingId) const;
+
+	/** Checks a hit claim against the server's view of the world. Fills OutCandidate if the claim is valid. */
+	bool ValidateHitClaim(const FARPGWeaponTraceState& State, const AARPGCharacter* Character, const FARPGWeaponHitClaim& Claim, FARPGWeaponTraceHitCandidate& OutCandidate) const;
+
+	/** Every state ever allocated by this subsystem. States are heap allocated so pointers to them stay stable. */
+	TArray<TUniquePtr<FARPGWeaponTraceState>> AllStates;
+
+	/** States that are not in use */
+	TArray<FARPGWeaponTraceState*> FreeStates;
+
+	/** States that are in use */
+	TMap<FStateKey, FARPGWeaponTraceState*> ActiveStates;
+
+	/** States that are in use or waiting on async sweeps, by swing id */
+	TMap<uint32, FARPGWeaponTraceState*> StatesBySwingId;
+
+	/** States that received async hits since the last tick */
+	TArray<FARPGWeaponTraceState*> StatesToProcess;
+
+	/** States whose swing ended but that are waiting on their release delay or async sweeps */
+	TArray<FARPGWeaponTraceState*> ReleasedStates;
+
+	/** Delegate passed to every async sweep */
+	FTraceDelegate AsyncSweepDelegate;
+
+	/** Last swing id handed out */
+	uint32 LastSwingId = 0;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGWeaponTraceTypes.h"
+
+FARPGWeaponBladePose FARPGWeaponBladePose::Interpolate(const FARPGWeaponBladePose& From, const FARPGWeaponBladePose& To, float Alpha)
+{
+	const FQuat Rotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha).GetNormalized();
+
+	// Blade vector in the local space of each pose, so the blade keeps its length while rotating
+	const FVector FromLocalBlade = From.Rotation.UnrotateVector(From.End - From.Start);
+	const FVector ToLocalBlade = To.Rotation.UnrotateVector(To.End - To.Start);
+
+	const FVector Start = FMath::Lerp(From.Start, To.Start, Alpha);
+	const FVector End = Start + Rotation.RotateVector(FMath::Lerp(FromLocalBlade, ToLocalBlade, Alpha));
+
+	return FARPGWeaponBladePose(Start, End, Rotation);
+}
+
+int32 ARPGWeaponTrace::ComputeNumSubsteps(const FARPGWeaponBladePose& From, const FARPGWeaponBladePose& To, float MaxStepDistance, float MaxStepAngleDegrees, int32 MaxSubsteps)
+{
+	MaxSubsteps = FMath::Max(1, MaxSubsteps);
+
+	int32 NumSubsteps = 1;
+
+	// The blade tip usually travels the furthest, but check the base too in case the whole weapon moved
+	if (MaxStepDistance > UE_KINDA_SMALL_NUMBER)
+	{
+		const double Travel = FMath::Max(FVector::Dist(From.Start, To.Start), FVector::Dist(From.End, To.End));
+		NumSubsteps = FMath::Max(NumSubsteps, FMath::CeilToInt32(Travel / MaxStepDistance));
+	}
+
+	if (MaxStepAngleDegrees > UE_KINDA_SMALL_NUMBER)
+	{
+		const double AngleDegrees = FMath::RadiansToDegrees(From.Rotation.AngularDistance(To.Rotation));
+		NumSubsteps = FMath::Max(NumSubsteps, FMath::CeilToInt32(AngleDegrees / MaxStepAngleDegrees));
+	}
+
+	return FMath::Min(NumSubsteps, MaxSubsteps);
+}
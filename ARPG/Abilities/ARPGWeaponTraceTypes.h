@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_STATS_GROUP(TEXT("ARPGAnimNotifications"), STATGROUP_ARPGAnimNotifications, STATCAT_Advanced);
+
+class AActor;
+class UAbilitySystemComponent;
+
+/**
+ * Position and orientation of a weapon blade at one point in time.
+ * Start/End are the world locations of the weapon's trace sockets.
+ */
+struct ARPG_API FARPGWeaponBladePose
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+
+	FARPGWeaponBladePose() = default;
+
+	FARPGWeaponBladePose(const FVector& InStart, const FVector& InEnd, const FQuat& InRotation)
+		: Start(InStart), End(InEnd), Rotation(InRotation)
+	{
+	}
+
+	/**
+	 * Interpolates between two blade poses. The blade pivots around its start point, so the rotation is slerped
+	 * and the blade is rebuilt from it instead of lerping both end points (which would shorten the blade mid-swing).
+	 */
+	static FARPGWeaponBladePose Interpolate(const FARPGWeaponBladePose& From, const FARPGWeaponBladePose& To, float Alpha);
+};
+
+/**
+ * An actor touched by a weapon trace, before the per-swing hit rules (hit once, multi-hit...) are applied.
+ * Comes from a local sweep, or from a client hit claim that passed validation on the server.
+ */
+struct FARPGWeaponTraceHitCandidate
+{
+	AActor* Actor = nullptr;
+	UAbilitySystemComponent* AbilitySystem = nullptr;
+
+	/** Blade pose of the sweep that touched the actor */
+	FVector BladeStart = FVector::ZeroVector;
+	FVector BladeEnd = FVector::ZeroVector;
+};
+
+namespace ARPGWeaponTrace
+{
+	/**
+	 * Returns how many evenly spaced poses are needed to cover the swing from one blade pose to another
+	 * so that no point of the blade moves more than MaxStepDistance, and the blade doesn't rotate more
+	 * than MaxStepAngleDegrees, between two consecutive poses. Always returns at least 1.
+	 */
+	ARPG_API int32 ComputeNumSubsteps(const FARPGWeaponBladePose& From, const FARPGWeaponBladePose& To, float MaxStepDistance, float MaxStepAngleDegrees, int32 MaxSubsteps);
+}
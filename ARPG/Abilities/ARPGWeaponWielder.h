@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "ARPGWeaponWielder.generated.h"
+
+class UStaticMeshComponent;
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UARPGWeaponWielder : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Implemented by actors that swing weapons, players and enemies alike, so that weapon traces
+ * can find the weapon mesh without knowing the actor's class.
+ */
+class ARPG_API IARPGWeaponWielder
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * @brief Returns the mesh of the currently equipped weapon, or null if unarmed or the weapon mesh is still loading
+	 */
+	virtual UStaticMeshComponent* GetWeaponMesh() const = 0;
+};
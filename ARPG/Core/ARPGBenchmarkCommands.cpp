@@ -0,0 +1,304 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Console commands used to benchmark and sanity check gameplay systems. These are meant to be run on a headless
+// server, e.g. `-server -nullrhi -ExecCmds="ARPG.Bench.SpawnEnemies /Game/Enemies/BP_Enemy.BP_Enemy_C 200"`
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "Logging/StructuredLog.h"
+#include "ARPG/ARPG.h"
+#include "ARPGEnemyCharacter.h"
+#include "ARPGNetUpdateFrequencySubsystem.h"
+#include "Engine/NetDriver.h"
+#include "ARPGPathRequestSubsystem.h"
+#include "NavigationSystem.h"
+#include "Containers/Ticker.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace ARPGBenchmarks
+{
+	/**
+	 * Spawns N enemies in a grid and reports how long spawning (including BeginPlay, where ability sets are granted) took.
+	 * Usage: ARPG.Bench.SpawnEnemies [EnemyClassPath] [Count=200] [Keep=0]
+	 */
+	static void SpawnEnemies(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			UE_LOGFMT(LogARPG, Warning, "ARPG.Bench.SpawnEnemies must be run on the server or in standalone.");
+			return;
+		}
+
+		UClass* EnemyClass = AARPGEnemyCharacter::StaticClass();
+		if (Args.Num() > 0 && !Args[0].IsNumeric())
+		{
+			EnemyClass = LoadClass<AARPGEnemyCharacter>(nullptr, *Args[0]);
+			if (!EnemyClass)
+			{
+				UE_LOGFMT(LogARPG, Error, "ARPG.Bench.SpawnEnemies could not load enemy class {0}.", Args[0]);
+				return;
+			}
+		}
+
+		const int32 CountArgIndex = (Args.Num() > 0 && !Args[0].IsNumeric()) ? 1 : 0;
+		const int32 Count = Args.IsValidIndex(CountArgIndex) ? FMath::Max(1, FCString::Atoi(*Args[CountArgIndex])) : 200;
+		const bool bKeep = Args.IsValidIndex(CountArgIndex + 1) && FCString::Atoi(*Args[CountArgIndex + 1]) != 0;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<AActor*> SpawnedEnemies;
+		SpawnedEnemies.Reserve(Count);
+
+		const int32 GridWidth = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+		constexpr float Spacing = 200.f;
+
+		const double StartTime = FPlatformTime::Seconds();
+		double SlowestSpawn = 0.0;
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const FVector Location((Index % GridWidth) * Spacing, (Index / GridWidth) * Spacing, 100.f);
+
+			const double SpawnStart = FPlatformTime::Seconds();
+			AActor* Enemy = World->SpawnActor<AActor>(EnemyClass, Location, FRotator::ZeroRotator, SpawnParams);
+			SlowestSpawn = FMath::Max(SlowestSpawn, FPlatformTime::Seconds() - SpawnStart);
+
+			if (Enemy)
+			{
+				SpawnedEnemies.Add(Enemy);
+			}
+		}
+
+		const double TotalMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOGFMT(LogARPG, Display, "ARPG.Bench.SpawnEnemies: spawned {0}/{1} {2} in {3} ms ({4} ms avg, {5} ms slowest)",
+			SpawnedEnemies.Num(), Count, EnemyClass->GetName(), TotalMs, TotalMs / FMath::Max(1, SpawnedEnemies.Num()), SlowestSpawn * 1000.0);
+
+		if (!bKeep)
+		{
+			for (AActor* Enemy : SpawnedEnemies)
+			{
+				Enemy->Destroy();
+			}
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs SpawnEnemiesCommand(
+		TEXT("ARPG.Bench.SpawnEnemies"),
+		TEXT("Spawns N enemies and reports the spawn cost. Usage: ARPG.Bench.SpawnEnemies [EnemyClassPath] [Count=200] [Keep=0]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnEnemies));
+
+	/**
+	 * State of a running ARPG.Bench.ServerReplication sample. Replication happens in the net driver's tick flush, which
+	 * is timed between the world's OnTickFlush and OnPostTickFlush events. Multicast events broadcast in reverse binding
+	 * order, so our OnTickFlush handler (bound after the net driver's) runs before the driver flushes.
+	 */
+	struct FServerReplicationSample
+	{
+		TWeakObjectPtr<UWorld> World;
+		FDelegateHandle TickFlushHandle;
+		FDelegateHandle PostTickFlushHandle;
+		double FlushStartTime = 0.0;
+		double EndTime = 0.0;
+		int32 ExpectedClients = 0;
+		TArray<double> FlushMs;
+		TArray<int32> NumClients;
+		TArray<float> TotalNetUpdateFrequency;
+	};
+
+	static TUniquePtr<FServerReplicationSample> ServerReplicationSample;
+
+	static void FinishServerReplicationSample()
+	{
+		FServerReplicationSample& Sample = *ServerReplicationSample;
+		if (UWorld* World = Sample.World.Get())
+		{
+			World->OnTickFlush().Remove(Sample.TickFlushHandle);
+			World->OnPostTickFlush().Remove(Sample.PostTickFlushHandle);
+		}
+
+		if (Sample.FlushMs.Num() > 0)
+		{
+			TArray<double> SortedMs = Sample.FlushMs;
+			SortedMs.Sort();
+
+			double TotalMs = 0.0;
+			for (const double Ms : SortedMs)
+			{
+				TotalMs += Ms;
+			}
+
+			const int32 MinClients = FMath::Min(Sample.NumClients);
+			const int32 MaxClients = FMath::Max(Sample.NumClients);
+			float AverageFrequency = 0.f;
+			for (const float Frequency : Sample.TotalNetUpdateFrequency)
+			{
+				AverageFrequency += Frequency / Sample.TotalNetUpdateFrequency.Num();
+			}
+
+			UE_LOGFMT(LogARPG, Display, "ARPG.Bench.ServerReplication: {0} frames, {1}-{2} clients, adaptive net frequency {3}",
+				SortedMs.Num(), MinClients, MaxClients, IConsoleManager::Get().FindConsoleVariable(TEXT("ARPG.NetFrequency.Enabled"))->GetBool() ? TEXT("on") : TEXT("off"));
+			UE_LOGFMT(LogARPG, Display, "ARPG.Bench.ServerReplication: replication {0} ms avg, {1} ms median, {2} ms p95, {3} ms max per frame",
+				TotalMs / SortedMs.Num(), SortedMs[SortedMs.Num() / 2], SortedMs[FMath::Min(SortedMs.Num() - 1, SortedMs.Num() * 95 / 100)], SortedMs.Last());
+			UE_LOGFMT(LogARPG, Display, "ARPG.Bench.ServerReplication: registered actors considered for replication {0} times per second on average",
+				AverageFrequency);
+
+			if (MinClients < Sample.ExpectedClients)
+			{
+				UE_LOGFMT(LogARPG, Warning, "ARPG.Bench.ServerReplication: expected {0} clients but only {1} were connected for the whole sample.",
+					Sample.ExpectedClients, MinClients);
+			}
+		}
+
+		ServerReplicationSample.Reset();
+	}
+
+	/**
+	 * Times server replication (the net driver's tick flush) over a few seconds and reports it with the number of
+	 * connected clients. Bot clients are separate processes, see ARPG.Bench.BotAutopilot.
+	 * Run it once with ARPG.NetFrequency.Enabled 0 and once with 1 to compare.
+	 * It needs real client connections, so it stays a command. The boost and idle policy itself is covered by the
+	 * ARPG.Network.NetUpdateFrequency.BoostAndIdle automation test.
+	 * Usage: ARPG.Bench.ServerReplication [Seconds=10] [ExpectedClients=64]
+	 */
+	static void ServerReplication(const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (!NetDriver || !NetDriver->IsServer())
+		{
+			UE_LOGFMT(LogARPG, Warning, "ARPG.Bench.ServerReplication must be run on a server.");
+			return;
+		}
+
+		if (ServerReplicationSample)
+		{
+			UE_LOGFMT(LogARPG, Warning, "ARPG.Bench.ServerReplication is already running.");
+			return;
+		}
+
+		const float Seconds = Args.IsValidIndex(0) ? FMath::Max(1.f, FCString::Atof(*Args[0])) : 10.f;
+
+		ServerReplicationSample = MakeUnique<FServerReplicationSample>();
+		FServerReplicationSample& Sample = *ServerReplicationSample;
+		Sample.World = World;
+		Sample.ExpectedClients = Args.IsValidIndex(1) ? FMath::Max(0, FCString::Atoi(*Args[1])) : 64;
+		Sample.EndTime = FPlatformTime::Seconds() + Seconds;
+
+		Sample.TickFlushHandle = World->OnTickFlush().AddLambda([](float DeltaSeconds)
+			{
+				ServerReplicationSample->FlushStartTime = FPlatformTime::Seconds();
+			});
+
+		Sample.PostTickFlushHandle = World->OnPostTickFlush().AddLambda([]()
+			{
+				FServerReplicationSample& Sample = *ServerReplicationSample;
+				const double Now = FPlatformTime::Seconds();
+				const UWorld* World = Sample.World.Get();
+				const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+				if (!NetDriver)
+				{
+					FinishServerReplicationSample();
+					return;
+				}
+
+				Sample.FlushMs.Add((Now - Sample.FlushStartTime) * 1000.0);
+				Sample.NumClients.Add(NetDriver->ClientConnections.Num());
+
+				const UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(World);
+				Sample.TotalNetUpdateFrequency.Add(NetFrequency ? NetFrequency->GetStats().TotalNetUpdateFrequency : 0.f);
+
+				if (Now >= Sample.EndTime)
+				{
+					FinishServerReplicationSample();
+				}
+			});
+
+		UE_LOGFMT(LogARPG, Display, "ARPG.Bench.ServerReplication: sampling {0} seconds with {1} clients connected.",
+			Seconds, NetDriver->ClientConnections.Num());
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ServerReplicationCommand(
+		TEXT("ARPG.Bench.ServerReplication"),
+		TEXT("Times server replication per frame with the connected (bot) clients. Usage: ARPG.Bench.ServerReplication [Seconds=10] [ExpectedClients=64]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ServerReplication));
+
+	static FTSTicker::FDelegateHandle BotAutopilotHandle;
+
+	/**
+	 * Turns a client into a load test bot: every few seconds its pawn click-moves to a random reachable point nearby,
+	 * through the same path request queue as player clicks. Meant for headless bot clients connected to a load test server:
+	 *   server: `ARPG <LoadTestMap> -server -nullrhi -log`
+	 *   bots:   `ARPG <ServerIP> -game -nullrhi -nosound -ExecCmds="ARPG.Bench.BotAutopilot 1"` (one process per bot)
+	 * Clicks are resolved against the client's navmesh, so the project must allow client side navigation.
+	 * Usage: ARPG.Bench.BotAutopilot [Enable=1] [Radius=2000] [IntervalSeconds=3]
+	 */
+	static void BotAutopilot(const TArray<FString>& Args, UWorld* World)
+	{
+		if (BotAutopilotHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(BotAutopilotHandle);
+			BotAutopilotHandle.Reset();
+		}
+
+		const bool bEnable = !Args.IsValidIndex(0) || FCString::Atoi(*Args[0]) != 0;
+		if (!bEnable || !World)
+		{
+			UE_LOGFMT(LogARPG, Display, "ARPG.Bench.BotAutopilot: off.");
+			return;
+		}
+
+		const float Radius = Args.IsValidIndex(1) ? FMath::Max(100.f, FCString::Atof(*Args[1])) : 2000.f;
+		const float Interval = Args.IsValidIndex(2) ? FMath::Max(0.1f, FCString::Atof(*Args[2])) : 3.f;
+
+		BotAutopilotHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakWorld = TWeakObjectPtr<UWorld>(World), Radius](float DeltaTime)
+			{
+				UWorld* World = WeakWorld.Get();
+				if (!World)
+				{
+					BotAutopilotHandle.Reset();
+					return false;
+				}
+
+				// Still connecting or waiting for a pawn
+				APlayerController* PlayerController = World->GetFirstPlayerController();
+				const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+				UARPGPathRequestSubsystem* PathRequests = UARPGPathRequestSubsystem::Get(World);
+				if (!Pawn || !PathRequests)
+				{
+					return true;
+				}
+
+				// Clients only have a navigation system with client side navigation enabled, without one the bot would stand still
+				UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+				if (!NavigationSystem)
+				{
+					UE_LOGFMT(LogARPG, Warning, "ARPG.Bench.BotAutopilot: no navigation system in {0}, stopping. Bot clients need "
+						"Allow Client Side Navigation enabled in the Navigation System project settings.", World->GetName());
+					BotAutopilotHandle.Reset();
+					return false;
+				}
+
+				FNavLocation Goal;
+				if (NavigationSystem->GetRandomReachablePointInRadius(Pawn->GetActorLocation(), Radius, Goal))
+				{
+					PathRequests->RequestMoveToLocation(PlayerController, Goal.Location);
+				}
+
+				return true;
+			}), Interval);
+
+		UE_LOGFMT(LogARPG, Display, "ARPG.Bench.BotAutopilot: moving to a random point within {0} units every {1} seconds.", Radius, Interval);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BotAutopilotCommand(
+		TEXT("ARPG.Bench.BotAutopilot"),
+		TEXT("Makes the local player wander around, for load test bot clients. Usage: ARPG.Bench.BotAutopilot [Enable=1] [Radius=2000] [IntervalSeconds=3]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BotAutopilot));
+}
+
+#endif // !UE_BUILD_SHIPPING
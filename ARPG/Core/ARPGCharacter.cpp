@@ -15,6 +15,10 @@
 #include "ARPGPlayerState.h"
 #include "MVVMGameSubsystem.h"
 #include "ARPG/Input/ARPGEnhancedInputComponent.h"
+#include "ARPG/Abilities/ARPGLagCompensationSubsystem.h"
+#include "ARPGNetUpdateFrequencySubsystem.h"
+#include "ARPGHealthBarSubsystem.h"
+#include "ARPG/Equipment/EquipSlot.h"
 
 AARPGCharacter::AARPGCharacter()
 {
@@ -24,9 +28,8 @@ AARPGCharacter::AARPGCharacter()
 	bUseControllerRotationYaw = false;
 	bUseControllerRotationRoll = false;
 
-	// Activate ticking in order to update the cursor every frame.
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	// The cursor is updated by the player controller, the character itself has nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
 
 	// --- Character Movement ---
 	GetCharacterMovement()->bOrientRotationToMovement = true; // Rotate character to moving direction
@@ -53,61 +56,82 @@ AARPGCharacter::AARPGCharacter()
 	AbilitySystemComponent->SetReplicationMode(EGameplayEffectReplicationMode::Mixed);
 	SetNetUpdateFrequency(100.f);
 
-	// --- Healthbar Widget ---
-	HealthbarWidgetComponent = CreateDefaultSubobject<UWidgetComponent>(TEXT("HealthbarWidgetComponent"));
-	HealthbarWidgetComponent->SetupAttachment(RootComponent);
-	HealthbarWidgetComponent->SetRelativeLocation(FVector(0.f, 0.f, 100.f));
-	HealthbarWidgetComponent->SetWidgetSpace(EWidgetSpace::Screen);
-	HealthbarWidgetComponent->SetDrawAtDesiredSize(true);
-	HealthbarWidgetComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	// --- Equipment ---
+	WeaponEquipSlot = CreateDefaultSubobject<UEquipSlot>(TEXT("WeaponEquipSlot"));
+	FGameplayTagContainer WeaponTags;
+	WeaponTags.AddTag(Item_Equipment_Melee_1H);
+	WeaponTags.AddTag(Item_Equipment_Melee_2H);
+	WeaponEquipSlot->InitSlot(TEXT("hand_r"), WeaponTags);
 
-	static ConstructorHelpers::FClassFinder<UUserWidget> HealthbarWidgetClassFinder(TEXT("/Script/UMG.WidgetBlueprintGeneratedClass'/Game/UI/W_PlayerCharacterFloatingHealthbar.W_PlayerCharacterFloatingHealthbar_C'"));
-	if (HealthbarWidgetClassFinder.Succeeded())
-	{
-		HealthbarWidgetComponent->SetWidgetClass(HealthbarWidgetClassFinder.Class);
-	}
+	// The overhead health bar is drawn by UARPGHealthBarSubsystem, see BeginPlay
 }
 
-void AARPGCharacter::Tick(float DeltaSeconds)
+void AARPGCharacter::BeginPlay()
 {
-	Super::Tick(DeltaSeconds);
+	Super::BeginPlay();
 
-	//if (HasAuthority())
-	//{
-	//	UE_LOG(LogTemp, Log, TEXT("\n--------------- Server Begin --------------- \n"));
-	//	AARPGPlayerState* PS = GetPlayerState<AARPGPlayerState>();
+	if (HasAuthority())
+	{
+		if (UARPGLagCompensationSubsystem* LagCompensation = UARPGLagCompensationSubsystem::Get(this))
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
 
-	//	if (!PS) return;
-	//	if (!PS->GetInventorySystemComponent()) return;
+		// The ASC lives on the player state, its changes boost this character as the avatar
+		if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+		{
+			NetFrequency->RegisterActor(this);
+		}
 
-	//	PS->GetInventorySystemComponent()->Set
+		if (DefaultWeaponData)
+		{
+			WeaponEquipSlot->TryEquip(DefaultWeaponData);
+		}
+	}
 
-	//	PS->GetInventorySystemComponent()->DebugDumpInventories();
-	//	UE_LOG(LogTemp, Log, TEXT("\n--------------- Server End --------------- \n"));
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->RegisterActor(this, GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + 10.f, EARPGHealthBarStyle::Player);
+		UpdateHealthBar();
+	}
+}
 
-	//}
-	//else
-	//{
-	//	UE_LOG(LogTemp, Log, TEXT("\n--------------- Client Begin --------------- \n"));
-	//	AARPGPlayerState* PS = GetPlayerState<AARPGPlayerState>();
+void AARPGCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UARPGLagCompensationSubsystem* LagCompensation = UARPGLagCompensationSubsystem::Get(this))
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
 
-	//	if (!PS) return;
-	//	if (!PS->GetInventorySystemComponent()) return;
+	if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+	{
+		NetFrequency->UnregisterActor(this);
+	}
 
-	//	PS->GetInventorySystemComponent()->DebugDumpInventories();
-	//	UE_LOG(LogTemp, Log, TEXT("\n--------------- Client End --------------- \n"));
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->UnregisterActor(this);
+	}
 
-	//}
+	Super::EndPlay(EndPlayReason);
 }
 
-void AARPGCharacter::BeginPlay()
+UAbilitySystemComponent* AARPGCharacter::GetAbilitySystemComponent() const
 {
-	Super::BeginPlay();
+	return AbilitySystemComponent;
 }
 
-UAbilitySystemComponent* AARPGCharacter::GetAbilitySystemComponent() const
+UStaticMeshComponent* AARPGCharacter::GetWeaponMesh() const
 {
-	return AbilitySystemComponent;
+	return WeaponEquipSlot ? WeaponEquipSlot->GetGearMeshComponent() : nullptr;
+}
+
+void AARPGCharacter::ServerSubmitWeaponHitClaims_Implementation(const TArray<FARPGWeaponHitClaim>& Claims)
+{
+	if (UARPGWeaponTraceSubsystem* WeaponTraceSubsystem = UARPGWeaponTraceSubsystem::Get(this))
+	{
+		WeaponTraceSubsystem->HandleHitClaims(this, Claims);
+	}
 }
 
 void AARPGCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -133,6 +157,7 @@ void AARPGCharacter::PossessedBy(AController* NewController)
 		// Update property to use the ASC of the player state 
 		AbilitySystemComponent = Cast<UARPGAbilitySystemComponent>(PS->GetAbilitySystemComponent());
 		AbilitySystemComponent->InitAbilityActorInfo(PS, this);
+		UpdateHealthBar();
 	}
 
 }
@@ -149,6 +174,7 @@ void AARPGCharacter::OnRep_PlayerState()
 		AbilitySystemComponent = Cast<UARPGAbilitySystemComponent>(PS->GetAbilitySystemComponent());
 		AbilitySystemComponent->InitAbilityActorInfo(PS, this);
 		OnAbilitySystemComponentUpdated(AbilitySystemComponent);
+		UpdateHealthBar();
 
 		// Initialize player stats viewmodel
 		if (PS->GetPlayerStatsViewModel())
@@ -163,6 +189,19 @@ void AARPGCharacter::OnRep_PlayerState()
 	}
 }
 
+void AARPGCharacter::UpdateHealthBar() const
+{
+	UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this);
+	if (!HealthBars || !AbilitySystemComponent || !AbilitySystemComponent->HasAttributeSetForAttribute(UARPGHealthAttributeSet::GetHealthAttribute()))
+	{
+		return;
+	}
+
+	HealthBars->SetHealth(this,
+		AbilitySystemComponent->GetNumericAttribute(UARPGHealthAttributeSet::GetHealthAttribute()),
+		AbilitySystemComponent->GetNumericAttribute(UARPGHealthAttributeSet::GetHealthMaxAttribute()));
+}
+
 void AARPGCharacter::Input_AbilityInputTagPressed(FGameplayTag InputTag)
 {
 	if (AbilitySystemComponent)
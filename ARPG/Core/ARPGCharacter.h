@@ -8,12 +8,16 @@
 #include "AbilitySystemInterface.h"
 #include "ARPG/Input/ARPGInputConfig.h"
 #include "ARPGViewModelPlayerStats.h"
-#include "Components/WidgetComponent.h"
+#include "ARPG/Abilities/ARPGWeaponTraceSubsystem.h"
+#include "ARPG/Abilities/ARPGWeaponWielder.h"
 #include "ARPGCharacter.generated.h"
 
+class UEquipSlot;
+class UEquipmentData;
+
 
 UCLASS(Blueprintable)
-class AARPGCharacter : public ACharacter, public IAbilitySystemInterface
+class AARPGCharacter : public ACharacter, public IAbilitySystemInterface, public IARPGWeaponWielder
 {
 	GENERATED_BODY()
 
@@ -26,8 +30,8 @@ public:
 	//~ End ACharacter
 
 	//~ Begin AActor
-	virtual void Tick(float DeltaSeconds) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	//~ End AActor
 
 	//~ Being APawn
@@ -53,12 +57,22 @@ public:
 	UARPGViewModelPlayerStats* GetPlayerStatsViewModel() const { return PlayerStatsViewModel; }
 
 
+	/** Returns the slot holding this character's weapon **/
+	FORCEINLINE UEquipSlot* GetWeaponEquipSlot() const { return WeaponEquipSlot; }
+
 	/**
-	 * @brief Returns the mesh for the currently equipped weapon if one exists
-	 * TODO: Get the mesh from the equipment system
+	 * @brief Returns the mesh for the currently equipped weapon if one exists.
+	 *	Null while nothing is equipped or the weapon mesh is still loading.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
-	UStaticMeshComponent* GetWeaponMesh() const { return nullptr; }
+	virtual UStaticMeshComponent* GetWeaponMesh() const override;
+
+	/**
+	 * @brief Sends the hits found by this client's weapon trace to the server, which validates them
+	 *	and applies the valid ones. See UARPGAnimNotifyStateWeaponTrace.
+	 */
+	UFUNCTION(Server, Reliable)
+	void ServerSubmitWeaponHitClaims(const TArray<FARPGWeaponHitClaim>& Claims);
 
 
 protected:
@@ -67,18 +81,21 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Abilities")
 	UARPGAbilitySystemComponent* AbilitySystemComponent;
 
-	/** Widget component for the player healthbar */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "UI")
-	UWidgetComponent* HealthbarWidgetComponent;
-
 	/** Input config data asset. This should probably be moved elsewhere */
 	UPROPERTY(EditDefaultsOnly, Category = "Input")
 	UARPGInputConfig* InputConfig;
 
+	/** Weapon equipped on game start. Optional. */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	TObjectPtr<UEquipmentData> DefaultWeaponData;
+
 	/** Callback functions executed when ability inputs are pressed/released */
 	void Input_AbilityInputTagReleased(FGameplayTag InputTag);
 	void Input_AbilityInputTagPressed(FGameplayTag InputTag);
 
+	/** Client only - Pushes the current health of the ASC to this character's overhead health bar */
+	void UpdateHealthBar() const;
+
 protected:
 
 	UFUNCTION(BlueprintImplementableEvent)
@@ -100,6 +117,10 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
 
+	/** Slot attaching the equipped weapon to the character's hand. Its mesh is what the weapon trace sweeps */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<UEquipSlot> WeaponEquipSlot;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Viewmodel")
 	UARPGViewModelPlayerStats* PlayerStatsViewModel;
 };
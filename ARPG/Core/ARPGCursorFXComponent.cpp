@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGCursorFXComponent.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "GameFramework/Controller.h"
+
+UARPGCursorFXComponent::UARPGCursorFXComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UARPGCursorFXComponent::ShouldPlayEffects() const
+{
+	const AController* Controller = Cast<AController>(GetOwner());
+	return GetNetMode() != NM_DedicatedServer && (!Controller || Controller->IsLocalController());
+}
+
+void UARPGCursorFXComponent::Prewarm(UNiagaraSystem* System)
+{
+	if (!System || !ShouldPlayEffects())
+	{
+		return;
+	}
+
+	while (EffectComponents.Num() < MaxActiveEffects)
+	{
+		UNiagaraComponent* EffectComponent = NewObject<UNiagaraComponent>(GetOwner());
+		EffectComponent->SetAutoActivate(false);
+		EffectComponent->SetAutoDestroy(false);
+		EffectComponent->SetUsingAbsoluteLocation(true);
+		EffectComponent->SetUsingAbsoluteRotation(true);
+		EffectComponent->SetUsingAbsoluteScale(true);
+		EffectComponent->SetAsset(System);
+		EffectComponent->RegisterComponent();
+		EffectComponents.Add(EffectComponent);
+	}
+
+	for (UNiagaraComponent* EffectComponent : EffectComponents)
+	{
+		if (EffectComponent->GetAsset() != System)
+		{
+			EffectComponent->SetAsset(System);
+		}
+	}
+}
+
+void UARPGCursorFXComponent::PlayAtLocation(UNiagaraSystem* System, FVector Location)
+{
+	if (!System || !ShouldPlayEffects())
+	{
+		return;
+	}
+
+	Prewarm(System);
+	if (EffectComponents.Num() == 0)
+	{
+		return;
+	}
+
+	// Prefer a component that finished playing, otherwise restart the oldest one
+	int32 EffectIndex = EffectComponents.IndexOfByPredicate([](const UNiagaraComponent* EffectComponent) { return !EffectComponent->IsActive(); });
+	if (EffectIndex == INDEX_NONE)
+	{
+		EffectIndex = NextEffectIndex % EffectComponents.Num();
+	}
+	NextEffectIndex = (EffectIndex + 1) % EffectComponents.Num();
+
+	UNiagaraComponent* EffectComponent = EffectComponents[EffectIndex];
+	EffectComponent->SetWorldLocation(Location);
+	EffectComponent->Activate(/* bReset = */ true);
+}
+
+void UARPGCursorFXComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (UNiagaraComponent* EffectComponent : EffectComponents)
+	{
+		if (EffectComponent)
+		{
+			EffectComponent->DestroyComponent();
+		}
+	}
+	EffectComponents.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
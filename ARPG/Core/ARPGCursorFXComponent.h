@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ARPGCursorFXComponent.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraComponent;
+
+/**
+ * Plays click feedback FX (e.g., the click-to-move cursor effect) from a small ring of Niagara components.
+ *
+ * The components are created once, up front, and reused for every click, so spam clicking never spawns or
+ * destroys components. At most MaxActiveEffects play at once; a click beyond that restarts the oldest one.
+ */
+UCLASS(ClassGroup = (ARPG), meta = (BlueprintSpawnableComponent))
+class ARPG_API UARPGCursorFXComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UARPGCursorFXComponent();
+
+	/** Creates the components for the given system ahead of the first click. Only does anything for local players. */
+	UFUNCTION(BlueprintCallable, Category = "Cursor FX")
+	void Prewarm(UNiagaraSystem* System);
+
+	/** Plays the system at the location, reusing a pooled component */
+	UFUNCTION(BlueprintCallable, Category = "Cursor FX")
+	void PlayAtLocation(UNiagaraSystem* System, FVector Location);
+
+	/** Number of components kept, and so the maximum number of effects playing at once */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cursor FX", meta = (ClampMin = 1, UIMax = 8))
+	int32 MaxActiveEffects = 3;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Returns whether effects should play for the owner, i.e. it's a local player's controller (or something not networked) */
+	bool ShouldPlayEffects() const;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNiagaraComponent>> EffectComponents;
+
+	/** Component used by the next click when none is idle. Components are used in order, so this is the oldest one. */
+	int32 NextEffectIndex = 0;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGCursorHitProvider.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+
+UARPGCursorHitProvider::UARPGCursorHitProvider()
+{
+	// Only does work when asked
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UARPGCursorHitProvider::GetCursorHit(FHitResult& OutHit, bool bTouch)
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if (!PlayerController || !PlayerController->IsLocalController())
+	{
+		return false;
+	}
+
+	FVector2D ScreenPosition;
+	if (!GetPointerScreenPosition(PlayerController, bTouch, ScreenPosition))
+	{
+		return false;
+	}
+
+	const APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+	const FVector CameraLocation = CameraManager ? CameraManager->GetCameraLocation() : FVector::ZeroVector;
+	const FRotator CameraRotation = CameraManager ? CameraManager->GetCameraRotation() : FRotator::ZeroRotator;
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	const bool bCanReuse = bCachedHitValid && bCachedForTouch == bTouch
+		&& (CachedFrame == GFrameCounter
+			|| (Now - CachedTime <= MaxHitReuseTime
+				&& FVector2D::DistSquared(ScreenPosition, CachedScreenPosition) <= FMath::Square(ScreenPositionTolerance)
+				&& CameraLocation.Equals(CachedCameraLocation, 0.1)
+				&& CameraRotation.Equals(CachedCameraRotation, 0.01)));
+
+	if (bCanReuse)
+	{
+		INC_DWORD_STAT(STAT_ARPGCursorHitProvider_Reuses);
+		OutHit = CachedHit;
+		return bCachedHitBlocking;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ARPGCursorHitProvider_Trace);
+		INC_DWORD_STAT(STAT_ARPGCursorHitProvider_Traces);
+		bCachedHitBlocking = PlayerController->GetHitResultAtScreenPosition(ScreenPosition, TraceChannel, bTraceComplex, CachedHit);
+	}
+
+	bCachedHitValid = true;
+	bCachedForTouch = bTouch;
+	CachedFrame = GFrameCounter;
+	CachedTime = Now;
+	CachedScreenPosition = ScreenPosition;
+	CachedCameraLocation = CameraLocation;
+	CachedCameraRotation = CameraRotation;
+
+	OutHit = CachedHit;
+	return bCachedHitBlocking;
+}
+
+void UARPGCursorHitProvider::InvalidateCursorHit()
+{
+	bCachedHitValid = false;
+}
+
+bool UARPGCursorHitProvider::GetPointerScreenPosition(const APlayerController* PlayerController, bool bTouch, FVector2D& OutScreenPosition) const
+{
+	if (bTouch)
+	{
+		float TouchX = 0.f;
+		float TouchY = 0.f;
+		bool bIsPressed = false;
+		PlayerController->GetInputTouchState(ETouchIndex::Touch1, TouchX, TouchY, bIsPressed);
+		OutScreenPosition = FVector2D(TouchX, TouchY);
+		return bIsPressed;
+	}
+
+	float MouseX = 0.f;
+	float MouseY = 0.f;
+	if (!PlayerController->GetMousePosition(MouseX, MouseY))
+	{
+		return false;
+	}
+
+	OutScreenPosition = FVector2D(MouseX, MouseY);
+	return true;
+}
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/HitResult.h"
+#include "ARPGCursorHitProvider.generated.h"
+
+class APlayerController;
+
+DECLARE_STATS_GROUP(TEXT("ARPGInput"), STATGROUP_ARPGInput, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Cursor Trace"), STAT_ARPGCursorHitProvider_Trace, STATGROUP_ARPGInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cursor Traces"), STAT_ARPGCursorHitProvider_Traces, STATGROUP_ARPGInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cursor Trace Reuses"), STAT_ARPGCursorHitProvider_Reuses, STATGROUP_ARPGInput);
+
+/**
+ * Single source for what is under the mouse cursor (or the first touch) of a player controller.
+ *
+ * Click-to-move, targeting and hover highlighting all ask this component instead of tracing themselves. It traces
+ * at most once per frame, and keeps reusing the last hit while neither the cursor nor the camera moved.
+ */
+UCLASS(ClassGroup = (ARPG), meta = (BlueprintSpawnableComponent))
+class ARPG_API UARPGCursorHitProvider : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UARPGCursorHitProvider();
+
+	/**
+	 * @brief Returns what is under the cursor this frame. Traces only if nothing was cached for this frame and the cursor or camera moved.
+	 * @param OutHit The hit under the cursor
+	 * @param bTouch Use the first touch instead of the mouse cursor
+	 * @return True if something was hit
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Cursor")
+	bool GetCursorHit(FHitResult& OutHit, bool bTouch = false);
+
+	/** Forgets the cached hit, forcing the next query to trace */
+	UFUNCTION(BlueprintCallable, Category = "Cursor")
+	void InvalidateCursorHit();
+
+	/**
+	 * Channel the cursor traces against. Visibility by default; point it at a dedicated channel that only low-poly
+	 * walkable and targetable collision responds to, to keep cursor traces cheap on dense maps.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cursor")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+	/** Trace against complex (per-poly) collision. Much more expensive, only needed if simple collision is missing. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cursor")
+	bool bTraceComplex = false;
+
+	/**
+	 * A cached hit is reused for at most this many seconds even if the cursor and camera didn't move, so things moving
+	 * under a still cursor are picked up. 0 retraces every frame the cursor is queried.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cursor", meta = (ClampMin = 0))
+	float MaxHitReuseTime = 0.1f;
+
+	/** How far (in pixels) the cursor may move before the cached hit is traced again */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cursor", meta = (ClampMin = 0))
+	float ScreenPositionTolerance = 0.5f;
+
+private:
+	/** Screen position of the cursor or touch. False if there is none (e.g., no viewport or the finger is up). */
+	bool GetPointerScreenPosition(const APlayerController* PlayerController, bool bTouch, FVector2D& OutScreenPosition) const;
+
+	FHitResult CachedHit;
+	bool bCachedHitValid = false;
+	bool bCachedHitBlocking = false;
+	bool bCachedForTouch = false;
+
+	/** Frame, time, pointer and camera the cached hit was traced with */
+	uint64 CachedFrame = 0;
+	double CachedTime = 0.0;
+	FVector2D CachedScreenPosition = FVector2D::ZeroVector;
+	FVector CachedCameraLocation = FVector::ZeroVector;
+	FRotator CachedCameraRotation = FRotator::ZeroRotator;
+};
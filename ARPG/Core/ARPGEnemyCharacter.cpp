@@ -3,6 +3,14 @@
 
 #include "ARPGEnemyCharacter.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "ARPG/Abilities/ARPGLagCompensationSubsystem.h"
+#include "ARPGPathRequestSubsystem.h"
+#include "ARPGNetUpdateFrequencySubsystem.h"
+#include "ARPGHealthBarSubsystem.h"
+#include "ARPGNativeGameplayTags.h"
+#include "ARPG/Equipment/EquipSlot.h"
+#include "Components/CapsuleComponent.h"
 
 // Sets default values
 AARPGEnemyCharacter::AARPGEnemyCharacter()
@@ -26,8 +34,15 @@ AARPGEnemyCharacter::AARPGEnemyCharacter()
 
 	HealthAttributeSet = CreateDefaultSubobject<UARPGHealthAttributeSet>(TEXT("HealthAttributeSet"));
 
-	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Configure the weapon slot, same hand and weapon types as the player characters
+	WeaponEquipSlot = CreateDefaultSubobject<UEquipSlot>(TEXT("WeaponEquipSlot"));
+	FGameplayTagContainer WeaponTags;
+	WeaponTags.AddTag(Item_Equipment_Melee_1H);
+	WeaponTags.AddTag(Item_Equipment_Melee_2H);
+	WeaponEquipSlot->InitSlot(TEXT("hand_r"), WeaponTags);
+
+	// Enemies have no per-frame logic of their own, components tick at rates set by the significance subsystem
+	PrimaryActorTick.bCanEverTick = false;
 }
 
 UAbilitySystemComponent* AARPGEnemyCharacter::GetAbilitySystemComponent() const
@@ -35,6 +50,11 @@ UAbilitySystemComponent* AARPGEnemyCharacter::GetAbilitySystemComponent() const
 	return AbilitySystemComponent;
 }
 
+UStaticMeshComponent* AARPGEnemyCharacter::GetWeaponMesh() const
+{
+	return WeaponEquipSlot ? WeaponEquipSlot->GetGearMeshComponent() : nullptr;
+}
+
 void AARPGEnemyCharacter::PossessedBy(AController* NewController)
 {
 	Super::PossessedBy(NewController);
@@ -49,13 +69,68 @@ void AARPGEnemyCharacter::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
-	if (GetNetMode() != NM_DedicatedServer && AbilitySystemComponent)
+	UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this);
+	if (GetNetMode() != NM_DedicatedServer && AbilitySystemComponent && AttributeRouter)
+	{
+		const FGameplayAttribute CoreAttributes[] = { UARPGHealthAttributeSet::GetHealthAttribute(), UARPGHealthAttributeSet::GetHealthMaxAttribute() };
+		CoreAttributeListenerHandle = AttributeRouter->AddListener(AbilitySystemComponent, CoreAttributes, EARPGAttributeChangeDispatch::Coalesced,
+			FARPGAttributeChangeListener::CreateUObject(this, &AARPGEnemyCharacter::HandleCoreAttributeValueChanged));
+	}
+
+	if (HasAuthority() && HealthAttributeSet)
+	{
+		HealthAttributeSet->OnOutOfHealth.AddUObject(this, &AARPGEnemyCharacter::HandleOutOfHealth);
+	}
+}
+
+void AARPGEnemyCharacter::RequestMoveToLocation(const FVector& GoalLocation)
+{
+	if (UARPGPathRequestSubsystem* PathRequests = UARPGPathRequestSubsystem::Get(this))
 	{
-		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(HealthAttributeSet->GetHealthAttribute()).AddUObject(this, &AARPGEnemyCharacter::HandleCoreAttributeValueChanged);
-		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(HealthAttributeSet->GetHealthMaxAttribute()).AddUObject(this, &AARPGEnemyCharacter::HandleCoreAttributeValueChanged);
+		PathRequests->RequestMoveToLocation(GetController(), GoalLocation);
 	}
 }
 
+void AARPGEnemyCharacter::SetSignificance(EARPGSignificance NewSignificance)
+{
+	if (Significance == NewSignificance)
+	{
+		return;
+	}
+
+	Significance = NewSignificance;
+	const FARPGSignificanceSettings& Settings = UARPGSignificanceSubsystem::GetSettings(NewSignificance);
+
+	if (USkeletalMeshComponent* MeshComponent = GetMesh())
+	{
+		MeshComponent->SetComponentTickInterval(Settings.AnimationTickInterval);
+	}
+
+	if (UCharacterMovementComponent* MovementComponent = GetCharacterMovement())
+	{
+		MovementComponent->SetComponentTickInterval(Settings.MovementTickInterval);
+	}
+
+	if (HasAuthority())
+	{
+		if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+		{
+			NetFrequency->SetMaxNetUpdateFrequency(this, Settings.NetUpdateFrequency);
+		}
+		else
+		{
+			SetNetUpdateFrequency(Settings.NetUpdateFrequency);
+		}
+	}
+
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->SetUpdateInterval(this, Settings.HealthBarUpdateInterval);
+	}
+
+	OnSignificanceChanged.Broadcast(this, NewSignificance);
+}
+
 // Called when the game starts or when spawned
 void AARPGEnemyCharacter::BeginPlay()
 {
@@ -63,10 +138,70 @@ void AARPGEnemyCharacter::BeginPlay()
 
 	if (HasAuthority())
 	{
+		// Attributes first: effects granted by the ability sets create aggregators the direct init would bypass
+		InitializeAttributes();
 		GrantInitialAbilitySets();
+
+		if (DefaultWeaponData)
+		{
+			WeaponEquipSlot->TryEquip(DefaultWeaponData);
+		}
+
+		if (UARPGLagCompensationSubsystem* LagCompensation = UARPGLagCompensationSubsystem::Get(this))
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+
+		if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+		{
+			NetFrequency->RegisterActor(this, AbilitySystemComponent);
+		}
+	}
+
+	if (UARPGSignificanceSubsystem* SignificanceSubsystem = UARPGSignificanceSubsystem::Get(this))
+	{
+		SignificanceSubsystem->RegisterEnemy(this);
+	}
+
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->RegisterActor(this, GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + 10.f, EARPGHealthBarStyle::Enemy);
+		HealthBars->SetHealth(this, HealthAttributeSet->GetHealth(), HealthAttributeSet->GetHealthMax());
+		HealthBars->SetUpdateInterval(this, UARPGSignificanceSubsystem::GetSettings(Significance).HealthBarUpdateInterval);
 	}
 }
 
+void AARPGEnemyCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UARPGLagCompensationSubsystem* LagCompensation = UARPGLagCompensationSubsystem::Get(this))
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+	{
+		NetFrequency->UnregisterActor(this);
+	}
+
+	if (UARPGSignificanceSubsystem* SignificanceSubsystem = UARPGSignificanceSubsystem::Get(this))
+	{
+		SignificanceSubsystem->UnregisterEnemy(this);
+	}
+
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->UnregisterActor(this);
+	}
+
+	if (UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this))
+	{
+		AttributeRouter->RemoveListener(AbilitySystemComponent, CoreAttributeListenerHandle);
+		CoreAttributeListenerHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AARPGEnemyCharacter::GrantInitialAbilitySets()
 {
 	// Grant ability sets
@@ -83,19 +218,26 @@ void AARPGEnemyCharacter::GrantInitialAbilitySets()
 	}
 }
 
-void AARPGEnemyCharacter::HandleCoreAttributeValueChanged(const FOnAttributeChangeData& Data)
+void AARPGEnemyCharacter::InitializeAttributes()
 {
-	// Update the view model with new attribute values
-	if (Data.Attribute == UARPGHealthAttributeSet::GetHealthAttribute())
+	if (!AttributeInitTable)
 	{
-		// TODO: Update the health bar widget for this enemy
+		return;
 	}
-	else if (Data.Attribute == UARPGHealthAttributeSet::GetHealthMaxAttribute())
-	{
-		// TODO: Update the health bar widget for this enemy
-	}
-	else
+
+	AttributeInitTable->ApplyToAbilitySystem(AbilitySystemComponent, AttributeInitArchetype, CharacterLevel);
+}
+
+void AARPGEnemyCharacter::HandleCoreAttributeValueChanged(const FARPGAttributeChange& Change)
+{
+	// Update the overhead health bar with new attribute values
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Enemy Core attribute changed, but the attribute that changed was not handled."));
+		HealthBars->SetHealth(this, HealthAttributeSet->GetHealth(), HealthAttributeSet->GetHealthMax());
 	}
 }
+
+void AARPGEnemyCharacter::HandleOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser, const FGameplayEffectSpec* DamageEffectSpec, float DamageMagnitude, float OldValue, float NewValue)
+{
+	K2_OnOutOfHealth(DamageInstigator, DamageCauser);
+}
@@ -8,10 +8,19 @@
 #include "ARPG/Abilities/ARPGAbilitySystemComponent.h"
 #include "ARPG/Abilities/ARPGAbilitySet.h"
 #include "ARPG/Abilities/ARPGHealthAttributeSet.h"
+#include "ARPG/Abilities/ARPGAttributeInitTable.h"
+#include "ARPG/Abilities/ARPGAttributeChangeRouter.h"
+#include "ARPG/Abilities/ARPGWeaponWielder.h"
+#include "ARPGSignificanceSubsystem.h"
 #include "ARPGEnemyCharacter.generated.h"
 
+class UEquipSlot;
+class UEquipmentData;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FARPGEnemySignificanceChanged, AARPGEnemyCharacter* /*Enemy*/, EARPGSignificance /*NewSignificance*/);
+
 UCLASS()
-class ARPG_API AARPGEnemyCharacter : public ACharacter, public IAbilitySystemInterface
+class ARPG_API AARPGEnemyCharacter : public ACharacter, public IAbilitySystemInterface, public IARPGWeaponWielder
 {
 	GENERATED_BODY()
 
@@ -23,12 +32,37 @@ public:
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 	//~ End IAbilitySystemInterface
 
+	/**
+	 * @brief Returns the mesh for the currently equipped weapon if one exists.
+	 *	Null while nothing is equipped or the weapon mesh is still loading.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	virtual UStaticMeshComponent* GetWeaponMesh() const override;
+
+	/** Returns the slot holding this enemy's weapon */
+	UEquipSlot* GetWeaponEquipSlot() const { return WeaponEquipSlot; }
+
 	virtual void PossessedBy(AController* NewController) override;
 	virtual void PostInitializeComponents() override;
 
+	/** Moves this enemy to the location through the path request queue. Use this instead of synchronous move-to calls. */
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void RequestMoveToLocation(const FVector& GoalLocation);
+
+	/** How much this enemy currently matters to the players */
+	UFUNCTION(BlueprintPure, Category = "Performance")
+	EARPGSignificance GetSignificance() const { return Significance; }
+
+	/** Applies the update rates of the significance level. Called by the significance subsystem. */
+	void SetSignificance(EARPGSignificance NewSignificance);
+
+	/** Broadcast after the significance of this enemy changed */
+	FARPGEnemySignificanceChanged OnSignificanceChanged;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/** ASC for this enemy */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Abilities")
@@ -38,13 +72,49 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
 	TArray<TObjectPtr<UARPGAbilitySet>> AbilitySets;
 
+	/** Slot attaching the equipped weapon to the enemy's hand. Its mesh is what the weapon trace sweeps */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon")
+	TObjectPtr<UEquipSlot> WeaponEquipSlot;
+
+	/** Weapon equipped on spawn. Optional. */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	TObjectPtr<UEquipmentData> DefaultWeaponData;
+
 	/** Core attribute sets used by all entities that can do combat */
 	UPROPERTY()
 	TObjectPtr<const UARPGHealthAttributeSet> HealthAttributeSet;
 
+	/** Table containing the starting attributes of this enemy. Optional. */
+	UPROPERTY(EditDefaultsOnly, Category = "Attributes")
+	TObjectPtr<UARPGAttributeInitTable> AttributeInitTable;
+
+	/** Archetype of this enemy in the AttributeInitTable */
+	UPROPERTY(EditDefaultsOnly, Category = "Attributes")
+	FName AttributeInitArchetype;
+
+	/** Handle of the core attribute listener registered with the attribute change router */
+	FDelegateHandle CoreAttributeListenerHandle;
+
+	/** Level used to evaluate the starting attributes */
+	UPROPERTY(EditAnywhere, Category = "Attributes", meta = (ClampMin = 1))
+	int32 CharacterLevel = 1;
+
+	/** Current significance, starts fully updated until the subsystem evaluated this enemy */
+	EARPGSignificance Significance = EARPGSignificance::High;
+
 	/** Grants ability sets to the enemy and performs other necessary initialization */
 	void GrantInitialAbilitySets();
 
+	/** Writes the starting attributes of this enemy's archetype into its attribute sets */
+	void InitializeAttributes();
+
 	/** Function that handles changes to core attributes and updates UI */
-	virtual void HandleCoreAttributeValueChanged(const FOnAttributeChangeData& Data);
+	virtual void HandleCoreAttributeValueChanged(const FARPGAttributeChange& Change);
+
+	/** Server only - Called once when this enemy's health reaches zero */
+	virtual void HandleOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser, const FGameplayEffectSpec* DamageEffectSpec, float DamageMagnitude, float OldValue, float NewValue);
+
+	/** Server only - Blueprint hook for when this enemy's health reaches zero */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Attributes", meta = (DisplayName = "On Out Of Health"))
+	void K2_OnOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser);
 };
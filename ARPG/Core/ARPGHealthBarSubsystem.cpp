@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGHealthBarSubsystem.h"
+#include "SARPGHealthBarLayer.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "SceneView.h"
+#include "UnrealClient.h"
+
+namespace ARPGHealthBars
+{
+	static TAutoConsoleVariable<int32> CVarMaxVisible(
+		TEXT("ARPG.HealthBars.MaxVisible"),
+		64,
+		TEXT("Maximum number of health bars drawn at once. The bars closest to the camera win."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarMaxDistance(
+		TEXT("ARPG.HealthBars.MaxDistance"),
+		5000.f,
+		TEXT("Health bars of actors further than this from the camera aren't drawn."),
+		ECVF_Default);
+}
+
+UARPGHealthBarSubsystem* UARPGHealthBarSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGHealthBarSubsystem>() : nullptr;
+}
+
+bool UARPGHealthBarSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UARPGHealthBarSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::UpdateVisibleBars);
+}
+
+void UARPGHealthBarSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	if (Layer.IsValid())
+	{
+		if (UGameViewportClient* ViewportClient = GetWorld()->GetGameViewport())
+		{
+			ViewportClient->RemoveViewportWidgetContent(Layer.ToSharedRef());
+		}
+		Layer.Reset();
+	}
+
+	DEC_DWORD_STAT_BY(STAT_ARPGHealthBars_Registered, Bars.Num());
+	Bars.Empty();
+	BarIndices.Empty();
+	VisibleBars.Empty();
+
+	Super::Deinitialize();
+}
+
+void UARPGHealthBarSubsystem::RegisterActor(const AActor* Actor, float VerticalOffset, EARPGHealthBarStyle Style)
+{
+	if (!Actor || BarIndices.Contains(Actor))
+	{
+		return;
+	}
+
+	BarIndices.Add(Actor, Bars.Num());
+	FHealthBar& Bar = Bars.AddDefaulted_GetRef();
+	Bar.Actor = Actor;
+	Bar.ActorKey = Actor;
+	Bar.VerticalOffset = VerticalOffset;
+	Bar.Style = Style;
+
+	INC_DWORD_STAT(STAT_ARPGHealthBars_Registered);
+}
+
+void UARPGHealthBarSubsystem::UnregisterActor(const AActor* Actor)
+{
+	if (const int32* Index = BarIndices.Find(Actor))
+	{
+		RemoveBarAt(*Index);
+	}
+}
+
+void UARPGHealthBarSubsystem::SetHealth(const AActor* Actor, float Health, float HealthMax)
+{
+	if (const int32* Index = BarIndices.Find(Actor))
+	{
+		Bars[*Index].HealthFraction = HealthMax > 0.f ? FMath::Clamp(Health / HealthMax, 0.f, 1.f) : 0.f;
+	}
+}
+
+void UARPGHealthBarSubsystem::SetUpdateInterval(const AActor* Actor, float UpdateInterval)
+{
+	if (const int32* Index = BarIndices.Find(Actor))
+	{
+		FHealthBar& Bar = Bars[*Index];
+		Bar.UpdateInterval = UpdateInterval;
+
+		// Show the latest health right away when the bar becomes more important
+		Bar.NextUpdateTime = FMath::Min(Bar.NextUpdateTime, GetWorld()->GetTimeSeconds() + FMath::Max(UpdateInterval, 0.f));
+	}
+}
+
+void UARPGHealthBarSubsystem::RemoveBarAt(int32 Index)
+{
+	BarIndices.Remove(Bars[Index].ActorKey);
+	Bars.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Bars.IsValidIndex(Index))
+	{
+		BarIndices.FindChecked(Bars[Index].ActorKey) = Index;
+	}
+
+	DEC_DWORD_STAT(STAT_ARPGHealthBars_Registered);
+}
+
+void UARPGHealthBarSubsystem::EnsureLayer()
+{
+	if (Layer.IsValid())
+	{
+		return;
+	}
+
+	if (UGameViewportClient* ViewportClient = GetWorld()->GetGameViewport())
+	{
+		Layer = SNew(SARPGHealthBarLayer, this);
+
+		// Below the regular UMG widgets
+		ViewportClient->AddViewportWidgetContent(Layer.ToSharedRef(), -1);
+	}
+}
+
+void UARPGHealthBarSubsystem::UpdateVisibleBars(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	// The delegate fires for every world
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ARPGHealthBars_Update);
+
+	VisibleBars.Reset();
+	VisibleBarDistances.Reset();
+
+	if (Bars.Num() == 0)
+	{
+		return;
+	}
+
+	EnsureLayer();
+
+	// The camera managers have been updated this frame, so the projection matches the frame about to be rendered
+	const APlayerController* PlayerController = World->GetFirstPlayerController();
+	const ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	FViewport* Viewport = LocalPlayer && LocalPlayer->ViewportClient ? LocalPlayer->ViewportClient->Viewport : nullptr;
+
+	FSceneViewProjectionData ProjectionData;
+	if (!Viewport || !LocalPlayer->GetProjectionData(Viewport, ProjectionData))
+	{
+		return;
+	}
+
+	// One projection for every bar instead of a ProjectWorldLocationToScreen per actor
+	const FMatrix ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+	const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+	const FVector2f ViewportSize(Viewport->GetSizeXY());
+	const FVector ViewOrigin = ProjectionData.ViewOrigin;
+	const float MaxDistanceSquared = FMath::Square(ARPGHealthBars::CVarMaxDistance.GetValueOnGameThread());
+	const double Now = World->GetTimeSeconds();
+
+	for (int32 Index = Bars.Num() - 1; Index >= 0; --Index)
+	{
+		FHealthBar& Bar = Bars[Index];
+		const AActor* Actor = Bar.Actor.Get();
+		if (!Actor)
+		{
+			RemoveBarAt(Index);
+			continue;
+		}
+
+		if (Bar.UpdateInterval < 0.f || Actor->IsHidden())
+		{
+			continue;
+		}
+
+		if (Now >= Bar.NextUpdateTime)
+		{
+			Bar.DisplayedHealthFraction = Bar.HealthFraction;
+			Bar.NextUpdateTime = Now + Bar.UpdateInterval;
+		}
+
+		if (Bar.Style == EARPGHealthBarStyle::Enemy && Bar.DisplayedHealthFraction >= 1.f)
+		{
+			continue;
+		}
+
+		const FVector WorldLocation = Actor->GetActorLocation() + FVector(0.f, 0.f, Bar.VerticalOffset);
+		const float DistanceSquared = FVector::DistSquared(WorldLocation, ViewOrigin);
+		if (DistanceSquared > MaxDistanceSquared)
+		{
+			continue;
+		}
+
+		FVector2D ScreenPosition;
+		if (!FSceneView::ProjectWorldToScreen(WorldLocation, ViewRect, ViewProjectionMatrix, ScreenPosition))
+		{
+			continue;
+		}
+
+		const FVector2f ViewportPosition = FVector2f(ScreenPosition) / ViewportSize;
+		if (ViewportPosition.X < 0.f || ViewportPosition.X > 1.f || ViewportPosition.Y < 0.f || ViewportPosition.Y > 1.f)
+		{
+			continue;
+		}
+
+		VisibleBars.Add({ ViewportPosition, Bar.DisplayedHealthFraction, Bar.Style });
+		VisibleBarDistances.Add(DistanceSquared);
+	}
+
+	// Keep the closest bars
+	const int32 MaxVisible = FMath::Max(0, ARPGHealthBars::CVarMaxVisible.GetValueOnGameThread());
+	if (VisibleBars.Num() > MaxVisible)
+	{
+		TArray<int32> Order;
+		Order.SetNumUninitialized(VisibleBars.Num());
+		for (int32 Index = 0; Index < Order.Num(); ++Index)
+		{
+			Order[Index] = Index;
+		}
+		Order.Sort([this](int32 A, int32 B) { return VisibleBarDistances[A] < VisibleBarDistances[B]; });
+
+		TArray<FARPGHealthBarDrawItem> ClosestBars;
+		ClosestBars.Reserve(MaxVisible);
+		for (int32 Index = 0; Index < MaxVisible; ++Index)
+		{
+			ClosestBars.Add(VisibleBars[Order[Index]]);
+		}
+		VisibleBars = MoveTemp(ClosestBars);
+	}
+
+	INC_DWORD_STAT_BY(STAT_ARPGHealthBars_Drawn, VisibleBars.Num());
+}
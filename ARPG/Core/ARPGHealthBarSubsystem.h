@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "UObject/ObjectKey.h"
+#include "ARPGHealthBarSubsystem.generated.h"
+
+class SARPGHealthBarLayer;
+
+DECLARE_STATS_GROUP(TEXT("ARPGUI"), STATGROUP_ARPGUI, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Health Bar Update"), STAT_ARPGHealthBars_Update, STATGROUP_ARPGUI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Health Bars Registered"), STAT_ARPGHealthBars_Registered, STATGROUP_ARPGUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Bars Drawn"), STAT_ARPGHealthBars_Drawn, STATGROUP_ARPGUI);
+
+/** Look of a health bar */
+UENUM(BlueprintType)
+enum class EARPGHealthBarStyle : uint8
+{
+	Player,
+	Enemy		// Hidden while at full health
+};
+
+/** A health bar to draw this frame */
+struct FARPGHealthBarDrawItem
+{
+	/** Bottom center of the bar, in viewport coordinates from 0 to 1 */
+	FVector2f ViewportPosition;
+
+	float HealthFraction;
+
+	EARPGHealthBarStyle Style;
+};
+
+/**
+ * Client only - Overhead health bars of every character, drawn by a single screen-space layer.
+ *
+ * Characters register once and push their health when it changes. Every frame, once the cameras have been updated,
+ * the subsystem projects the registered characters with one view projection, culls the ones that are off screen or
+ * too far, keeps the closest ARPG.HealthBars.MaxVisible and hands them to SARPGHealthBarLayer, which draws all of them
+ * in two batched passes. There is no widget, component or tick per character.
+ *
+ * Bars are projected with the view of the first local player only. In split-screen, the other players get no bars.
+ */
+UCLASS()
+class ARPG_API UARPGHealthBarSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the health bar subsystem of the world the context object lives in. Null on dedicated servers. */
+	static UARPGHealthBarSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Starts drawing a health bar above the actor.
+	 *
+	 * @param Actor Actor the bar floats above
+	 * @param VerticalOffset Height of the bar above the actor's location
+	 * @param Style Look of the bar
+	 */
+	void RegisterActor(const AActor* Actor, float VerticalOffset, EARPGHealthBarStyle Style);
+	void UnregisterActor(const AActor* Actor);
+
+	/** Updates the health shown by the actor's bar. Ignored for actors without a bar. */
+	void SetHealth(const AActor* Actor, float Health, float HealthMax);
+
+	/** How often the health shown by the actor's bar refreshes. 0 is every frame, negative hides the bar. */
+	void SetUpdateInterval(const AActor* Actor, float UpdateInterval);
+
+	/** Bars to draw this frame */
+	TConstArrayView<FARPGHealthBarDrawItem> GetVisibleBars() const { return VisibleBars; }
+
+private:
+	struct FHealthBar
+	{
+		TWeakObjectPtr<const AActor> Actor;
+
+		TObjectKey<AActor> ActorKey;
+
+		// Latest health pushed by the actor
+		float HealthFraction = 1.f;
+
+		// Health currently shown, refreshed from HealthFraction every UpdateInterval
+		float DisplayedHealthFraction = 1.f;
+
+		float VerticalOffset = 0.f;
+
+		float UpdateInterval = 0.f;
+
+		double NextUpdateTime = 0.0;
+
+		EARPGHealthBarStyle Style = EARPGHealthBarStyle::Enemy;
+	};
+
+	/**
+	 * Gathers the bars to draw this frame. Runs after the world's actors and cameras have ticked, projecting in a
+	 * tickable tick would use the camera of the previous frame and the bars would trail behind a moving camera.
+	 */
+	void UpdateVisibleBars(UWorld* World, ELevelTick TickType, float DeltaTime);
+
+	void RemoveBarAt(int32 Index);
+
+	/** Adds the layer to the game viewport the first time there is something to draw */
+	void EnsureLayer();
+
+	TArray<FHealthBar> Bars;
+
+	/** Index into Bars for each actor */
+	TMap<TObjectKey<AActor>, int32> BarIndices;
+
+	TArray<FARPGHealthBarDrawItem> VisibleBars;
+
+	/** Squared distance to the camera of each visible bar, used to keep the closest ones */
+	TArray<float> VisibleBarDistances;
+
+	TSharedPtr<SARPGHealthBarLayer> Layer;
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -9,6 +9,8 @@ UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Roll, "Input.Ability.Core.Roll", "Defaul
 
 UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Block_AbilityInput, "Status.Block.AbilityInput", "ASC's with this gameplay tag cannot activate any abilities");
 
+UE_DEFINE_GAMEPLAY_TAG_COMMENT(SetByCaller_Damage, "SetByCaller.Damage", "Magnitude of damage applied by a gameplay effect");
+
 UE_DEFINE_GAMEPLAY_TAG_COMMENT(Item_Equipment_Melee_1H, "Item.Equipment.Melee.1H", "One handed melee weapon")
 UE_DEFINE_GAMEPLAY_TAG_COMMENT(Item_Equipment_Melee_2H, "Item.Equipment.Melee.2H", "Two handed melee weapon")
 UE_DEFINE_GAMEPLAY_TAG_COMMENT(Item_Equipment_Ring, "Item.Equipment.Ring", "Ring equipment")
@@ -14,6 +14,11 @@ UE_DECLARE_GAMEPLAY_TAG_EXTERN(InputTag_Roll);
 
 UE_DECLARE_GAMEPLAY_TAG_EXTERN(Status_Block_AbilityInput)
 
+/**
+ * Tags used to pass magnitudes to gameplay effects at runtime
+ */
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(SetByCaller_Damage)
+
 /**
  * Tags for equipment types
  */
@@ -0,0 +1,314 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGNetUpdateFrequencySubsystem.h"
+#include "ARPGReplicationGraph.h"
+#include "ARPG/Abilities/ARPGAttributeChangeRouter.h"
+#include "AbilitySystemComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+namespace ARPGNetFrequency
+{
+	static TAutoConsoleVariable<bool> CVarEnabled(
+		TEXT("ARPG.NetFrequency.Enabled"),
+		true,
+		TEXT("If false, registered actors always replicate at their full rate."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarIdleRate(
+		TEXT("ARPG.NetFrequency.IdleRate"),
+		5.f,
+		TEXT("Net update frequency of registered actors whose state hasn't changed recently."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarBoostDuration(
+		TEXT("ARPG.NetFrequency.BoostDuration"),
+		1.f,
+		TEXT("Seconds an actor keeps its full rate after its last state change."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarMovingSpeed(
+		TEXT("ARPG.NetFrequency.MovingSpeed"),
+		1.f,
+		TEXT("Speed above which an actor counts as moving and stays boosted."),
+		ECVF_Default);
+}
+
+UARPGNetUpdateFrequencySubsystem* UARPGNetUpdateFrequencySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGNetUpdateFrequencySubsystem>() : nullptr;
+}
+
+void UARPGNetUpdateFrequencySubsystem::Deinitialize()
+{
+	for (FTrackedActor& Tracked : TrackedActors)
+	{
+		ReleaseEntry(Tracked);
+	}
+	TrackedActors.Empty();
+	TrackedActorIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UARPGNetUpdateFrequencySubsystem::RegisterActor(AActor* Actor, UAbilitySystemComponent* AbilitySystem)
+{
+	if (!Actor || !Actor->HasAuthority() || TrackedActorIndices.Contains(Actor))
+	{
+		return;
+	}
+
+	TrackedActorIndices.Add(Actor, TrackedActors.Num());
+	FTrackedActor& Tracked = TrackedActors.AddDefaulted_GetRef();
+	Tracked.Actor = Actor;
+	Tracked.ActorKey = Actor;
+	Tracked.MaxNetUpdateFrequency = Actor->GetNetUpdateFrequency();
+
+	if (AbilitySystem)
+	{
+		Tracked.AbilitySystem = AbilitySystem;
+		const TWeakObjectPtr<UAbilitySystemComponent> WeakAbilitySystem(AbilitySystem);
+
+		Tracked.AbilityActivatedHandle = AbilitySystem->AbilityActivatedCallbacks.AddUObject(this, &ThisClass::OnAbilityActivated, WeakAbilitySystem);
+
+		// The router's bindings to the ASC are shared with the other listeners, and several changes in a frame boost once per attribute
+		if (UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this))
+		{
+			Tracked.AttributeListenerHandle = AttributeRouter->AddListener(AbilitySystem, UARPGAttributeChangeRouter::GetRoutedAttributes(),
+				EARPGAttributeChangeDispatch::Coalesced, FARPGAttributeChangeListener::CreateUObject(this, &ThisClass::OnAttributeChanged, WeakAbilitySystem));
+		}
+	}
+
+	// Newly registered actors have initial state to send
+	INC_DWORD_STAT(STAT_ARPGNetFrequency_Idle);
+	Boost(Tracked, GetWorld()->GetTimeSeconds());
+}
+
+void UARPGNetUpdateFrequencySubsystem::UnregisterActor(AActor* Actor)
+{
+	if (const int32* Index = TrackedActorIndices.Find(Actor))
+	{
+		RemoveEntryAt(*Index);
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::BoostActor(AActor* Actor)
+{
+	if (const int32* Index = TrackedActorIndices.Find(Actor))
+	{
+		Boost(TrackedActors[*Index], GetWorld()->GetTimeSeconds());
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::SetMaxNetUpdateFrequency(AActor* Actor, float MaxNetUpdateFrequency)
+{
+	const int32* Index = TrackedActorIndices.Find(Actor);
+	if (!Index)
+	{
+		if (Actor && Actor->HasAuthority())
+		{
+			ApplyNetUpdateFrequency(Actor, MaxNetUpdateFrequency);
+		}
+		return;
+	}
+
+	FTrackedActor& Tracked = TrackedActors[*Index];
+	Tracked.MaxNetUpdateFrequency = MaxNetUpdateFrequency;
+
+	if (Tracked.bBoosted)
+	{
+		ApplyNetUpdateFrequency(Actor, MaxNetUpdateFrequency);
+		Actor->SetMinNetUpdateFrequency(FMath::Min(ARPGNetFrequency::CVarIdleRate.GetValueOnGameThread(), MaxNetUpdateFrequency));
+	}
+	else
+	{
+		ApplyIdle(Tracked);
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::OnAbilityActivated(UGameplayAbility* Ability, TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem)
+{
+	BoostAbilitySystem(AbilitySystem.Get());
+}
+
+void UARPGNetUpdateFrequencySubsystem::OnAttributeChanged(const FARPGAttributeChange& Change, TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem)
+{
+	BoostAbilitySystem(AbilitySystem.Get());
+}
+
+void UARPGNetUpdateFrequencySubsystem::BoostAbilitySystem(const UAbilitySystemComponent* AbilitySystem)
+{
+	if (!AbilitySystem)
+	{
+		return;
+	}
+
+	// The owner replicates the ASC, the avatar replicates montages and movement caused by the ability
+	AActor* Owner = AbilitySystem->GetOwnerActor();
+	AActor* Avatar = AbilitySystem->GetAvatarActor_Direct();
+
+	BoostActor(Owner);
+	if (Avatar != Owner)
+	{
+		BoostActor(Avatar);
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::Boost(FTrackedActor& Tracked, double Now)
+{
+	AActor* Actor = Tracked.Actor.Get();
+	if (!Actor)
+	{
+		return;
+	}
+
+	Tracked.BoostEndTime = Now + ARPGNetFrequency::CVarBoostDuration.GetValueOnGameThread();
+
+	if (!Tracked.bBoosted)
+	{
+		Tracked.bBoosted = true;
+		ApplyNetUpdateFrequency(Actor, Tracked.MaxNetUpdateFrequency);
+		Actor->SetMinNetUpdateFrequency(FMath::Min(ARPGNetFrequency::CVarIdleRate.GetValueOnGameThread(), Tracked.MaxNetUpdateFrequency));
+
+		INC_DWORD_STAT(STAT_ARPGNetFrequency_Boosted);
+		DEC_DWORD_STAT(STAT_ARPGNetFrequency_Idle);
+	}
+
+	// Don't wait for the next update at the (possibly idle) rate, replicate the change this frame
+	Actor->ForceNetUpdate();
+
+	++BoostsInWindow;
+	INC_DWORD_STAT(STAT_ARPGNetFrequency_Boosts);
+}
+
+void UARPGNetUpdateFrequencySubsystem::ApplyNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency) const
+{
+	Actor->SetNetUpdateFrequency(NetUpdateFrequency);
+
+	if (UARPGReplicationGraph* ReplicationGraph = UARPGReplicationGraph::Get(this))
+	{
+		ReplicationGraph->SetActorNetUpdateFrequency(Actor, NetUpdateFrequency);
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::ApplyIdle(FTrackedActor& Tracked)
+{
+	AActor* Actor = Tracked.Actor.Get();
+	if (!Actor)
+	{
+		return;
+	}
+
+	if (Tracked.bBoosted)
+	{
+		Tracked.bBoosted = false;
+		DEC_DWORD_STAT(STAT_ARPGNetFrequency_Boosted);
+		INC_DWORD_STAT(STAT_ARPGNetFrequency_Idle);
+	}
+
+	const float IdleRate = FMath::Min(ARPGNetFrequency::CVarIdleRate.GetValueOnGameThread(), Tracked.MaxNetUpdateFrequency);
+	const bool bEnabled = ARPGNetFrequency::CVarEnabled.GetValueOnGameThread();
+
+	ApplyNetUpdateFrequency(Actor, bEnabled ? IdleRate : Tracked.MaxNetUpdateFrequency);
+	Actor->SetMinNetUpdateFrequency(IdleRate);
+}
+
+void UARPGNetUpdateFrequencySubsystem::ReleaseEntry(FTrackedActor& Tracked)
+{
+	if (UAbilitySystemComponent* AbilitySystem = Tracked.AbilitySystem.Get())
+	{
+		AbilitySystem->AbilityActivatedCallbacks.Remove(Tracked.AbilityActivatedHandle);
+
+		if (UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this))
+		{
+			AttributeRouter->RemoveListener(AbilitySystem, Tracked.AttributeListenerHandle);
+		}
+	}
+
+	if (Tracked.bBoosted)
+	{
+		DEC_DWORD_STAT(STAT_ARPGNetFrequency_Boosted);
+	}
+	else
+	{
+		DEC_DWORD_STAT(STAT_ARPGNetFrequency_Idle);
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::RemoveEntryAt(int32 Index)
+{
+	FTrackedActor& Tracked = TrackedActors[Index];
+	ReleaseEntry(Tracked);
+	TrackedActorIndices.Remove(Tracked.ActorKey);
+
+	TrackedActors.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (TrackedActors.IsValidIndex(Index))
+	{
+		TrackedActorIndices.FindChecked(TrackedActors[Index].ActorKey) = Index;
+	}
+}
+
+void UARPGNetUpdateFrequencySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_ARPGNetFrequency_Update);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float MovingSpeedSquared = FMath::Square(ARPGNetFrequency::CVarMovingSpeed.GetValueOnGameThread());
+	const bool bEnabled = ARPGNetFrequency::CVarEnabled.GetValueOnGameThread();
+
+	int32 NumBoosted = 0;
+	float TotalNetUpdateFrequency = 0.f;
+
+	for (int32 Index = TrackedActors.Num() - 1; Index >= 0; --Index)
+	{
+		FTrackedActor& Tracked = TrackedActors[Index];
+		const AActor* Actor = Tracked.Actor.Get();
+		if (!Actor)
+		{
+			RemoveEntryAt(Index);
+			continue;
+		}
+
+		// Movement is the one state change without an event, poll it
+		const bool bMoving = Actor->GetVelocity().SizeSquared() > MovingSpeedSquared;
+
+		if (bMoving || !bEnabled)
+		{
+			if (Tracked.bBoosted)
+			{
+				Tracked.BoostEndTime = Now + ARPGNetFrequency::CVarBoostDuration.GetValueOnGameThread();
+			}
+			else
+			{
+				Boost(Tracked, Now);
+			}
+		}
+		else if (Tracked.bBoosted && Now >= Tracked.BoostEndTime)
+		{
+			ApplyIdle(Tracked);
+		}
+
+		NumBoosted += Tracked.bBoosted ? 1 : 0;
+		TotalNetUpdateFrequency += Actor->GetNetUpdateFrequency();
+	}
+
+	Stats.NumActors = TrackedActors.Num();
+	Stats.NumBoosted = NumBoosted;
+	Stats.TotalNetUpdateFrequency = TotalNetUpdateFrequency;
+
+	if (Now - StatsWindowStart >= 1.0)
+	{
+		Stats.BoostsPerSecond = FMath::RoundToInt(BoostsInWindow / (Now - StatsWindowStart));
+		BoostsInWindow = 0;
+		StatsWindowStart = Now;
+	}
+}
+
+TStatId UARPGNetUpdateFrequencySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGNetUpdateFrequencySubsystem, STATGROUP_Tickables);
+}
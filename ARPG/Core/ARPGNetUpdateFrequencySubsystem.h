@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ARPGNetUpdateFrequencySubsystem.generated.h"
+
+class UAbilitySystemComponent;
+class UGameplayAbility;
+struct FARPGAttributeChange;
+
+DECLARE_STATS_GROUP(TEXT("ARPGNetwork"), STATGROUP_ARPGNetwork, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Net Frequency Update"), STAT_ARPGNetFrequency_Update, STATGROUP_ARPGNetwork);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Frequency Boosts"), STAT_ARPGNetFrequency_Boosts, STATGROUP_ARPGNetwork);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors Boosted"), STAT_ARPGNetFrequency_Boosted, STATGROUP_ARPGNetwork);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors Idle"), STAT_ARPGNetFrequency_Idle, STATGROUP_ARPGNetwork);
+
+/**
+ * Stats about the actors driven by the net update frequency subsystem. Exposed so they can be shown in debug UI.
+ */
+USTRUCT(BlueprintType)
+struct FARPGNetUpdateFrequencyStats
+{
+	GENERATED_BODY()
+
+	// Number of registered actors
+	UPROPERTY(BlueprintReadOnly, Category = "Network")
+	int32 NumActors = 0;
+
+	// Number of registered actors currently replicating at their full rate
+	UPROPERTY(BlueprintReadOnly, Category = "Network")
+	int32 NumBoosted = 0;
+
+	// Boosts triggered over the last second
+	UPROPERTY(BlueprintReadOnly, Category = "Network")
+	int32 BoostsPerSecond = 0;
+
+	// Sum of the net update frequencies of all registered actors, i.e. how many times per second they are considered for replication
+	UPROPERTY(BlueprintReadOnly, Category = "Network")
+	float TotalNetUpdateFrequency = 0.f;
+};
+
+/**
+ * Server-side controller of the net update frequency of characters and player states.
+ *
+ * Registered actors replicate at a low idle rate (ARPG.NetFrequency.IdleRate) and are boosted to their full rate,
+ * with an immediate ForceNetUpdate, when their state changes: they start moving, one of their abilities activates,
+ * one of their attributes changes or their inventory is dirtied. They drop back to the idle rate once nothing has
+ * changed for ARPG.NetFrequency.BoostDuration seconds.
+ *
+ * The full rate of an actor is capped per actor, e.g. by the significance of an enemy, see SetMaxNetUpdateFrequency.
+ * When the world replicates through UARPGReplicationGraph, the graph's per-actor replication period follows along.
+ */
+UCLASS()
+class ARPG_API UARPGNetUpdateFrequencySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the net update frequency subsystem of the world the context object lives in */
+	static UARPGNetUpdateFrequencySubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Starts driving the net update frequency of the actor. Ignored if not called on the authority.
+	 *	The actor's current net update frequency becomes its full rate.
+	 *
+	 * @param Actor Actor to drive
+	 * @param AbilitySystem Optional ASC owned by the actor. Its ability activations and changes of the attributes routed by
+	 *	UARPGAttributeChangeRouter boost its owner and avatar.
+	 */
+	void RegisterActor(AActor* Actor, UAbilitySystemComponent* AbilitySystem = nullptr);
+	void UnregisterActor(AActor* Actor);
+
+	/** Replicates the actor at its full rate for a while and flags it for replication this frame */
+	void BoostActor(AActor* Actor);
+
+	/** Changes the full rate of the actor. The idle rate never exceeds it. */
+	void SetMaxNetUpdateFrequency(AActor* Actor, float MaxNetUpdateFrequency);
+
+	UFUNCTION(BlueprintCallable, Category = "Network|Debug")
+	const FARPGNetUpdateFrequencyStats& GetStats() const { return Stats; }
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	struct FTrackedActor
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		// Key of the actor in TrackedActorIndices, still valid once the actor is gone
+		TObjectKey<AActor> ActorKey;
+
+		TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem;
+
+		FDelegateHandle AbilityActivatedHandle;
+
+		// Handle of our UARPGAttributeChangeRouter listener on the ASC
+		FDelegateHandle AttributeListenerHandle;
+
+		// Rate used while boosted
+		float MaxNetUpdateFrequency = 100.f;
+
+		// World time at which a boosted actor goes back to idle
+		double BoostEndTime = 0.0;
+
+		bool bBoosted = false;
+	};
+
+	void OnAbilityActivated(UGameplayAbility* Ability, TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem);
+	void OnAttributeChanged(const FARPGAttributeChange& Change, TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem);
+
+	/** Boosts the owner and avatar of the ASC */
+	void BoostAbilitySystem(const UAbilitySystemComponent* AbilitySystem);
+
+	void Boost(FTrackedActor& Tracked, double Now);
+
+	/** Sets the net update frequency of the actor, and of its entry in the replication graph if the world uses one */
+	void ApplyNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency) const;
+
+	/** Applies the idle rate, or the full rate when adaptive frequencies are disabled */
+	void ApplyIdle(FTrackedActor& Tracked);
+
+	/** Unbinds from the ASC and fixes up the stats of an entry about to be removed */
+	void ReleaseEntry(FTrackedActor& Tracked);
+
+	void RemoveEntryAt(int32 Index);
+
+	TArray<FTrackedActor> TrackedActors;
+
+	/** Index into TrackedActors for each actor */
+	TMap<TObjectKey<AActor>, int32> TrackedActorIndices;
+
+	/** Boosts since StatsWindowStart */
+	int32 BoostsInWindow = 0;
+
+	double StatsWindowStart = 0.0;
+
+	FARPGNetUpdateFrequencyStats Stats;
+};
@@ -0,0 +1,363 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGPathRequestSubsystem.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshPath.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "AIController.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Logging/StructuredLog.h"
+
+namespace ARPGPathRequest
+{
+	static TAutoConsoleVariable<int32> CVarMaxQueriesPerFrame(
+		TEXT("ARPG.Path.MaxQueriesPerFrame"),
+		8,
+		TEXT("Maximum number of async path queries dispatched per frame. Further move requests wait in the queue."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarMergeRadius(
+		TEXT("ARPG.Path.MergeRadius"),
+		50.f,
+		TEXT("Move requests whose start and destination are both within this distance of another request's share its path."),
+		ECVF_Default);
+
+	static bool IsNear(const FVector& A, const FVector& B, float Radius)
+	{
+		return FVector::DistSquared(A, B) <= FMath::Square(Radius);
+	}
+
+	/**
+	 * Copies a path for another agent, keeping the navmesh corridor that path following uses for string pulling and
+	 * offsets. The copy repaths from the given querier instead of the agent the query was made for.
+	 */
+	static FNavPathSharedPtr CopyPath(const FNavigationPath& Source, const AController& Querier)
+	{
+		FNavPathSharedPtr Copy;
+		if (const FNavMeshPath* SourceNavMeshPath = Source.CastPath<FNavMeshPath>())
+		{
+			TSharedRef<FNavMeshPath, ESPMode::ThreadSafe> NavMeshPath = MakeShared<FNavMeshPath, ESPMode::ThreadSafe>();
+			NavMeshPath->PathCorridor = SourceNavMeshPath->PathCorridor;
+			NavMeshPath->PathCorridorCost = SourceNavMeshPath->PathCorridorCost;
+			NavMeshPath->SetWantsStringPulling(SourceNavMeshPath->WantsStringPulling());
+			NavMeshPath->SetWantsPathCorridor(SourceNavMeshPath->WantsPathCorridor());
+			Copy = NavMeshPath;
+		}
+		else
+		{
+			Copy = MakeShared<FNavigationPath, ESPMode::ThreadSafe>();
+		}
+
+		Copy->GetPathPoints() = Source.GetPathPoints();
+		Copy->SetNavigationDataUsed(Source.GetNavigationDataUsed());
+		Copy->SetIsPartial(Source.IsPartial());
+
+		FPathFindingQueryData QueryData = Source.GetQueryData();
+		QueryData.Owner = &Querier;
+		Copy->SetQueryData(QueryData);
+
+		Copy->MarkReady();
+		return Copy;
+	}
+}
+
+UARPGPathRequestSubsystem* UARPGPathRequestSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGPathRequestSubsystem>() : nullptr;
+}
+
+void UARPGPathRequestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PathQueryDelegate.BindUObject(this, &UARPGPathRequestSubsystem::OnPathQueryFinished);
+}
+
+void UARPGPathRequestSubsystem::Deinitialize()
+{
+	PathQueryDelegate.Unbind();
+	QueuedRequests.Empty();
+	InFlightQueries.Empty();
+
+	SET_DWORD_STAT(STAT_ARPGPathRequest_Queued, 0);
+
+	Super::Deinitialize();
+}
+
+void UARPGPathRequestSubsystem::RequestMoveToLocation(AController* Controller, FVector GoalLocation)
+{
+	if (!Controller || !Controller->GetPawn())
+	{
+		UE_LOGFMT(LogTemp, Warning, "RequestMoveToLocation called without a controller or pawn.");
+		return;
+	}
+
+	const float MergeRadius = ARPGPathRequest::CVarMergeRadius.GetValueOnGameThread();
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// The newest request of a controller wins, e.g. when a player spam clicks
+	bool bMerged = RemoveRequests(Controller);
+
+	if (UPathFollowingComponent* PathFollowingComponent = Controller->FindComponentByClass<UPathFollowingComponent>())
+	{
+		// Already walking there, keep the current path
+		const FNavPathSharedPtr& CurrentPath = PathFollowingComponent->GetPath();
+		if (PathFollowingComponent->GetStatus() == EPathFollowingStatus::Moving && CurrentPath.IsValid() && CurrentPath->IsValid()
+			&& ARPGPathRequest::IsNear(CurrentPath->GetDestinationLocation(), GoalLocation, MergeRadius))
+		{
+			++WindowMerged;
+			INC_DWORD_STAT(STAT_ARPGPathRequest_Merged);
+			return;
+		}
+	}
+
+	FMoveRequest Request;
+	Request.Controller = Controller;
+	Request.Goal = GoalLocation;
+	Request.RequestTime = Now;
+
+	// Share a query already on its way from nearby to nearby
+	const FVector Start = Controller->GetNavAgentLocation();
+	FPathQuery* SharedQuery = InFlightQueries.FindByPredicate([&](const FPathQuery& Query)
+		{
+			return ARPGPathRequest::IsNear(Query.Start, Start, MergeRadius) && ARPGPathRequest::IsNear(Query.Goal, GoalLocation, MergeRadius);
+		});
+
+	if (SharedQuery)
+	{
+		SharedQuery->Requests.Add(Request);
+		bMerged = true;
+	}
+	else
+	{
+		QueuedRequests.Add(Request);
+		WindowPeakQueueLength = FMath::Max(WindowPeakQueueLength, QueuedRequests.Num());
+	}
+
+	if (bMerged)
+	{
+		++WindowMerged;
+		INC_DWORD_STAT(STAT_ARPGPathRequest_Merged);
+	}
+}
+
+void UARPGPathRequestSubsystem::CancelMoveRequest(AController* Controller)
+{
+	RemoveRequests(Controller);
+}
+
+bool UARPGPathRequestSubsystem::RemoveRequests(const AController* Controller)
+{
+	auto IsFromController = [Controller](const FMoveRequest& Request) { return Request.Controller.Get() == Controller; };
+
+	int32 NumRemoved = QueuedRequests.RemoveAll(IsFromController);
+	for (FPathQuery& Query : InFlightQueries)
+	{
+		// The query itself keeps running for its other requests, or finishes into nothing
+		NumRemoved += Query.Requests.RemoveAll(IsFromController);
+	}
+
+	return NumRemoved > 0;
+}
+
+void UARPGPathRequestSubsystem::DispatchRequests()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGPathRequest_Dispatch);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (!NavSys || QueuedRequests.Num() == 0)
+	{
+		return;
+	}
+
+	const float MergeRadius = ARPGPathRequest::CVarMergeRadius.GetValueOnGameThread();
+	int32 Budget = ARPGPathRequest::CVarMaxQueriesPerFrame.GetValueOnGameThread();
+
+	int32 NumConsumed = 0;
+	for (; NumConsumed < QueuedRequests.Num() && Budget > 0; ++NumConsumed)
+	{
+		const FMoveRequest& Request = QueuedRequests[NumConsumed];
+		AController* Controller = Request.Controller.Get();
+		if (!Controller || !Controller->GetPawn())
+		{
+			continue;
+		}
+
+		const FVector Start = Controller->GetNavAgentLocation();
+
+		// A query dispatched earlier (possibly this frame) may already cover this request
+		FPathQuery* SharedQuery = InFlightQueries.FindByPredicate([&](const FPathQuery& Query)
+			{
+				return ARPGPathRequest::IsNear(Query.Start, Start, MergeRadius) && ARPGPathRequest::IsNear(Query.Goal, Request.Goal, MergeRadius);
+			});
+		if (SharedQuery)
+		{
+			SharedQuery->Requests.Add(Request);
+			++WindowMerged;
+			INC_DWORD_STAT(STAT_ARPGPathRequest_Merged);
+			continue;
+		}
+
+		const FNavAgentProperties& AgentProperties = Controller->GetNavAgentPropertiesRef();
+		const ANavigationData* NavData = NavSys->GetNavDataForProps(AgentProperties, Start);
+		if (!NavData)
+		{
+			continue;
+		}
+
+		FPathFindingQuery PathFindingQuery(Controller, *NavData, Start, Request.Goal);
+		PathFindingQuery.SetAllowPartialPaths(true);
+
+		const uint32 QueryId = NavSys->FindPathAsync(AgentProperties, PathFindingQuery, PathQueryDelegate);
+		if (QueryId == INVALID_NAVQUERYID)
+		{
+			continue;
+		}
+
+		FPathQuery& Query = InFlightQueries.AddDefaulted_GetRef();
+		Query.QueryId = QueryId;
+		Query.Start = Start;
+		Query.Goal = Request.Goal;
+		Query.Requests.Add(Request);
+
+		--Budget;
+		++WindowQueries;
+		INC_DWORD_STAT(STAT_ARPGPathRequest_Dispatched);
+	}
+
+	QueuedRequests.RemoveAt(0, NumConsumed, EAllowShrinking::No);
+}
+
+void UARPGPathRequestSubsystem::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	const int32 QueryIndex = InFlightQueries.IndexOfByPredicate([QueryId](const FPathQuery& Query) { return Query.QueryId == QueryId; });
+	if (QueryIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FPathQuery Query = MoveTemp(InFlightQueries[QueryIndex]);
+	InFlightQueries.RemoveAtSwap(QueryIndex, 1, EAllowShrinking::No);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const bool bSuccess = Result == ENavigationQueryResult::Success && Path.IsValid() && Path->IsValid();
+
+	bool bPathTaken = false;
+	for (const FMoveRequest& Request : Query.Requests)
+	{
+		++WindowCompleted;
+		WindowLatencySeconds += Now - Request.RequestTime;
+
+		AController* Controller = Request.Controller.Get();
+		if (!Controller || !Controller->GetPawn())
+		{
+			continue;
+		}
+
+		if (!bSuccess)
+		{
+			UPathFollowingComponent* PathFollowingComponent = GetPathFollowingComponent(*Controller);
+			if (PathFollowingComponent && PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle)
+			{
+				PathFollowingComponent->RequestMoveWithImmediateFinish(EPathFollowingResult::Invalid);
+			}
+			continue;
+		}
+
+		// Path following observes and may repath its path, so every agent sharing the query gets its own copy
+		const FNavPathSharedPtr RequestPath = bPathTaken ? ARPGPathRequest::CopyPath(*Path, *Controller) : Path;
+		bPathTaken = true;
+
+		StartMove(*Controller, Request.Goal, RequestPath);
+	}
+}
+
+void UARPGPathRequestSubsystem::StartMove(AController& Controller, const FVector& Goal, FNavPathSharedPtr Path) const
+{
+	UPathFollowingComponent* PathFollowingComponent = GetPathFollowingComponent(Controller);
+	if (!PathFollowingComponent || !PathFollowingComponent->IsPathFollowingAllowed())
+	{
+		return;
+	}
+
+	const bool bAlreadyAtGoal = PathFollowingComponent->HasReached(Goal, EPathFollowingReachMode::OverlapAgent);
+
+	// Keep only one move request at a time
+	if (PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		PathFollowingComponent->AbortMove(*this, FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest,
+			FAIRequestID::AnyRequest, bAlreadyAtGoal ? EPathFollowingVelocityMode::Reset : EPathFollowingVelocityMode::Keep);
+	}
+
+	if (bAlreadyAtGoal)
+	{
+		PathFollowingComponent->RequestMoveWithImmediateFinish(EPathFollowingResult::Success);
+	}
+	else
+	{
+		PathFollowingComponent->RequestMove(FAIMoveRequest(Goal), Path);
+	}
+}
+
+UPathFollowingComponent* UARPGPathRequestSubsystem::GetPathFollowingComponent(AController& Controller)
+{
+	if (const AAIController* AIController = Cast<AAIController>(&Controller))
+	{
+		return AIController->GetPathFollowingComponent();
+	}
+
+	UPathFollowingComponent* PathFollowingComponent = Controller.FindComponentByClass<UPathFollowingComponent>();
+	if (!PathFollowingComponent)
+	{
+		PathFollowingComponent = NewObject<UPathFollowingComponent>(&Controller);
+		PathFollowingComponent->RegisterComponentWithWorld(Controller.GetWorld());
+		PathFollowingComponent->Initialize();
+	}
+
+	return PathFollowingComponent;
+}
+
+void UARPGPathRequestSubsystem::UpdateStats(double Now)
+{
+	SET_DWORD_STAT(STAT_ARPGPathRequest_Queued, QueuedRequests.Num());
+
+	const double Elapsed = Now - StatsWindowStart;
+	if (Elapsed < 1.0)
+	{
+		return;
+	}
+
+	Stats.QueriesPerSecond = static_cast<float>(WindowQueries / Elapsed);
+	Stats.RequestsMergedPerSecond = FMath::RoundToInt(WindowMerged / Elapsed);
+	Stats.AverageLatencyMs = WindowCompleted > 0 ? static_cast<float>(WindowLatencySeconds / WindowCompleted * 1000.0) : 0.f;
+	Stats.PeakQueueLength = WindowPeakQueueLength;
+
+	SET_FLOAT_STAT(STAT_ARPGPathRequest_QueriesPerSecond, Stats.QueriesPerSecond);
+	SET_FLOAT_STAT(STAT_ARPGPathRequest_AverageLatency, Stats.AverageLatencyMs);
+
+	StatsWindowStart = Now;
+	WindowQueries = 0;
+	WindowMerged = 0;
+	WindowCompleted = 0;
+	WindowLatencySeconds = 0.0;
+
+	// Requests still waiting carry over into the new window
+	WindowPeakQueueLength = QueuedRequests.Num();
+}
+
+void UARPGPathRequestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	DispatchRequests();
+	UpdateStats(GetWorld()->GetTimeSeconds());
+}
+
+TStatId UARPGPathRequestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGPathRequestSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationData.h"
+#include "ARPGPathRequestSubsystem.generated.h"
+
+class AController;
+class UPathFollowingComponent;
+
+DECLARE_STATS_GROUP(TEXT("ARPGNavigation"), STATGROUP_ARPGNavigation, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Path Request Dispatch"), STAT_ARPGPathRequest_Dispatch, STATGROUP_ARPGNavigation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Dispatched"), STAT_ARPGPathRequest_Dispatched, STATGROUP_ARPGNavigation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Requests Merged"), STAT_ARPGPathRequest_Merged, STATGROUP_ARPGNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Requests Queued"), STAT_ARPGPathRequest_Queued, STATGROUP_ARPGNavigation);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Queries Per Second"), STAT_ARPGPathRequest_QueriesPerSecond, STATGROUP_ARPGNavigation);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Query Average Latency (ms)"), STAT_ARPGPathRequest_AverageLatency, STATGROUP_ARPGNavigation);
+
+/**
+ * Stats about path requests over the last second. Exposed so they can be shown in debug UI.
+ */
+USTRUCT(BlueprintType)
+struct FARPGPathRequestStats
+{
+	GENERATED_BODY()
+
+	// Navmesh queries dispatched per second
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float QueriesPerSecond = 0.f;
+
+	// Average time between a move being requested and its path arriving, in milliseconds
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float AverageLatencyMs = 0.f;
+
+	// Move requests served without a query of their own (replaced, merged into another query or already on a matching path)
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 RequestsMergedPerSecond = 0;
+
+	// Largest number of requests waiting to be dispatched at once during the last second
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 PeakQueueLength = 0;
+};
+
+/**
+ * Queue of move-to-location requests for player click-to-move and enemy AI.
+ *
+ * Instead of a synchronous navmesh query per request (as SimpleMoveToLocation does), requests are queued and
+ * dispatched as async path queries, at most ARPG.Path.MaxQueriesPerFrame per frame. Requests are deduplicated:
+ *  - a new request from a controller replaces its previous one if that hasn't been dispatched yet,
+ *  - a controller already following a path to (almost) the same destination keeps that path,
+ *  - requests from nearby agents to nearby destinations share one query.
+ */
+UCLASS()
+class ARPG_API UARPGPathRequestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the path request subsystem of the world the context object lives in */
+	static UARPGPathRequestSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Moves the controller's pawn to the goal along a navmesh path, like SimpleMoveToLocation but without a synchronous query.
+	 *	Unreachable goals move the pawn as close as the navmesh allows.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AI|Navigation")
+	void RequestMoveToLocation(AController* Controller, FVector GoalLocation);
+
+	/** Drops any request of the controller that is still waiting for its path */
+	UFUNCTION(BlueprintCallable, Category = "AI|Navigation")
+	void CancelMoveRequest(AController* Controller);
+
+	UFUNCTION(BlueprintCallable, Category = "AI|Navigation|Debug")
+	const FARPGPathRequestStats& GetStats() const { return Stats; }
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	struct FMoveRequest
+	{
+		TWeakObjectPtr<AController> Controller;
+		FVector Goal = FVector::ZeroVector;
+		double RequestTime = 0.0;
+	};
+
+	/** An async path query and every request waiting for it */
+	struct FPathQuery
+	{
+		uint32 QueryId = 0;
+		FVector Start = FVector::ZeroVector;
+		FVector Goal = FVector::ZeroVector;
+		TArray<FMoveRequest, TInlineAllocator<2>> Requests;
+	};
+
+	/** Dispatches queued requests as async queries, up to the per-frame budget */
+	void DispatchRequests();
+
+	/** Called on the game thread when an async query finished */
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** Starts following the path, the same way SimpleMoveToLocation does */
+	void StartMove(AController& Controller, const FVector& Goal, FNavPathSharedPtr Path) const;
+
+	/** Removes the controller's requests from the queue and from in-flight queries. Returns true if any was removed. */
+	bool RemoveRequests(const AController* Controller);
+
+	/** Returns the controller's path following component, creating one for player controllers like SimpleMoveToLocation does */
+	static UPathFollowingComponent* GetPathFollowingComponent(AController& Controller);
+
+	/** Updates the per-second stats */
+	void UpdateStats(double Now);
+
+	/** Requests waiting to be dispatched, oldest first */
+	TArray<FMoveRequest> QueuedRequests;
+
+	/** Queries waiting for their path */
+	TArray<FPathQuery> InFlightQueries;
+
+	FNavPathQueryDelegate PathQueryDelegate;
+
+	/** Counters for the current stats window */
+	double StatsWindowStart = 0.0;
+	int32 WindowQueries = 0;
+	int32 WindowMerged = 0;
+	int32 WindowCompleted = 0;
+	double WindowLatencySeconds = 0.0;
+	int32 WindowPeakQueueLength = 0;
+
+	FARPGPathRequestStats Stats;
+};
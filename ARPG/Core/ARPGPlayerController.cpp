@@ -2,9 +2,7 @@
 
 #include "ARPGPlayerController.h"
 #include "GameFramework/Pawn.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
 #include "NiagaraSystem.h"
-#include "NiagaraFunctionLibrary.h"
 #include "ARPGCharacter.h"
 #include "Engine/World.h"
 #include "EnhancedInputComponent.h"
@@ -12,6 +10,9 @@
 #include "EnhancedInputSubsystems.h"
 #include "ARPGPlayerState.h"
 #include "Engine/LocalPlayer.h"
+#include "ARPGCursorHitProvider.h"
+#include "ARPGPathRequestSubsystem.h"
+#include "ARPGCursorFXComponent.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -21,12 +22,19 @@ AARPGPlayerController::AARPGPlayerController()
 	DefaultMouseCursor = EMouseCursor::Default;
 	CachedDestination = FVector::ZeroVector;
 	FollowTime = 0.f;
+	bIsTouch = false;
+
+	CursorHitProvider = CreateDefaultSubobject<UARPGCursorHitProvider>(TEXT("CursorHitProvider"));
+	CursorFXComponent = CreateDefaultSubobject<UARPGCursorFXComponent>(TEXT("CursorFX"));
 }
 
 void AARPGPlayerController::BeginPlay()
 {
 	// Call the base class  
 	Super::BeginPlay();
+
+	// Create the click FX components now rather than on the first click
+	CursorFXComponent->Prewarm(FXCursor);
 }
 
 void AARPGPlayerController::SetupInputComponent()
@@ -76,6 +84,11 @@ void AARPGPlayerController::PostProcessInput(const float DeltaTime, const bool b
 void AARPGPlayerController::OnInputStarted()
 {
 	StopMovement();
+
+	if (UARPGPathRequestSubsystem* PathRequests = UARPGPathRequestSubsystem::Get(this))
+	{
+		PathRequests->CancelMoveRequest(this);
+	}
 }
 
 // Triggered every frame when the input is held down
@@ -86,15 +99,7 @@ void AARPGPlayerController::OnSetDestinationTriggered()
 
 	// We look for the location in the world where the player has pressed the input
 	FHitResult Hit;
-	bool bHitSuccessful = false;
-	if (bIsTouch)
-	{
-		bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
-	}
-	else
-	{
-		bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
-	}
+	const bool bHitSuccessful = CursorHitProvider->GetCursorHit(Hit, bIsTouch);
 
 	// If we hit a surface, cache the location
 	if (bHitSuccessful)
@@ -117,8 +122,11 @@ void AARPGPlayerController::OnSetDestinationReleased()
 	if (FollowTime <= ShortPressThreshold)
 	{
 		// We move there and spawn some particles
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, CachedDestination);
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None, true);
+		if (UARPGPathRequestSubsystem* PathRequests = UARPGPathRequestSubsystem::Get(this))
+		{
+			PathRequests->RequestMoveToLocation(this, CachedDestination);
+		}
+		CursorFXComponent->PlayAtLocation(FXCursor, CachedDestination);
 	}
 
 	FollowTime = 0.f;
@@ -11,6 +11,8 @@
 class UNiagaraSystem;
 class UInputMappingContext;
 class UInputAction;
+class UARPGCursorHitProvider;
+class UARPGCursorFXComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
@@ -42,7 +44,18 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
 	UInputAction* SetDestinationTouchAction;
 
+	/** Returns what is under the cursor, shared by movement, targeting and hover highlighting */
+	UARPGCursorHitProvider* GetCursorHitProvider() const { return CursorHitProvider; }
+
 protected:
+	/** Traces under the cursor at most once per frame, for everything that needs to know what the cursor points at */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Input)
+	TObjectPtr<UARPGCursorHitProvider> CursorHitProvider;
+
+	/** Plays FXCursor on clicks from a small pool of reused components */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Input)
+	TObjectPtr<UARPGCursorFXComponent> CursorFXComponent;
+
 	/** True if the controlled character should navigate to the mouse cursor. */
 	uint32 bMoveToMouseCursor : 1;
 
@@ -4,6 +4,8 @@
 #include "ARPGPlayerState.h"
 #include <MVVMGameSubsystem.h>
 #include "ARPGCharacter.h"
+#include "ARPGNetUpdateFrequencySubsystem.h"
+#include "ARPGHealthBarSubsystem.h"
 
 AARPGPlayerState::AARPGPlayerState()
 {
@@ -12,7 +14,7 @@ AARPGPlayerState::AARPGPlayerState()
 	bReplicates = true;
 	//bReplicateUsingRegisteredSubObjectList = true;
 
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 
 	// ISC
@@ -55,26 +57,30 @@ void AARPGPlayerState::PostInitializeComponents()
 void AARPGPlayerState::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+		{
+			NetFrequency->RegisterActor(this, AbilitySystemComponent);
+		}
+	}
 }
 
-void AARPGPlayerState::Tick(float DeltaSeconds)
+void AARPGPlayerState::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+	{
+		NetFrequency->UnregisterActor(this);
+	}
 
-	//if (HasAuthority())
-	//{
-	//	if (!GetInventorySystemComponent())
-	//	{
-	//		INVENTORY_LOG_SCREEN(TEXT("no isc"));
-
-	//	}
-	//	if (!InventoriesToGrant[0])
-	//	{
-	//		INVENTORY_LOG_SCREEN(TEXT("no inv to grant"));
-	//	}
-	//	InventorySystemComponent->CreateAndGiveInventory(InventoriesToGrant[0], FInventoryPermissionSet());
-
-	//}
+	if (UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this))
+	{
+		AttributeRouter->RemoveListener(AbilitySystemComponent, CoreAttributeListenerHandle);
+		CoreAttributeListenerHandle.Reset();
+	}
 
+	Super::EndPlay(EndPlayReason);
 }
 
 UAbilitySystemComponent* AARPGPlayerState::GetAbilitySystemComponent() const
@@ -96,15 +102,24 @@ void AARPGPlayerState::InitAbilitySystem()
 	}
 
 	// Setup handlers for when core gameplay attributes change (do this on client only)
-	if (GetNetMode() != NM_DedicatedServer)
+	// Coalesced, so any number of changes makes at most one call per attribute and frame. The handler reads both
+	// attributes, a frame changing both calls it twice with the same values.
+	UARPGAttributeChangeRouter* AttributeRouter = UARPGAttributeChangeRouter::Get(this);
+	if (GetNetMode() != NM_DedicatedServer && AttributeRouter)
 	{
-		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(UARPGHealthAttributeSet::GetHealthAttribute()).AddUObject(this, &AARPGPlayerState::HandleCoreAttributeValueChanged);
-		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(UARPGHealthAttributeSet::GetHealthMaxAttribute()).AddUObject(this, &AARPGPlayerState::HandleCoreAttributeValueChanged);
+		const FGameplayAttribute CoreAttributes[] = { UARPGHealthAttributeSet::GetHealthAttribute(), UARPGHealthAttributeSet::GetHealthMaxAttribute() };
+		CoreAttributeListenerHandle = AttributeRouter->AddListener(AbilitySystemComponent, CoreAttributes, EARPGAttributeChangeDispatch::Coalesced,
+			FARPGAttributeChangeListener::CreateUObject(this, &AARPGPlayerState::HandleCoreAttributeValueChanged));
 	}
 
 	// Grant all ability sets to the player
 	if (HasAuthority())
 	{
+		if (HealthAttributeSet)
+		{
+			HealthAttributeSet->OnOutOfHealth.AddUObject(this, &AARPGPlayerState::HandleOutOfHealth);
+		}
+
 		FARPGAbilitySet_GrantedHandles Handles;
 		for (const auto& AbilitySet : AbilitySets)
 		{
@@ -123,27 +138,31 @@ void AARPGPlayerState::InitAbilitySystem()
 
 
 // This function is only bound on the client side. See InitAbilitySystem
-void AARPGPlayerState::HandleCoreAttributeValueChanged(const FOnAttributeChangeData& Data)
+void AARPGPlayerState::HandleCoreAttributeValueChanged(const FARPGAttributeChange& Change)
 {
+	const float Health = HealthAttributeSet->GetHealth();
+	const float HealthMax = HealthAttributeSet->GetHealthMax();
+
+	// Every player's pawn has an overhead health bar, including the ones of other players
+	if (UARPGHealthBarSubsystem* HealthBars = UARPGHealthBarSubsystem::Get(this))
+	{
+		HealthBars->SetHealth(GetPawn(), Health, HealthMax);
+	}
+
 	if (!PlayerStatsViewModel)
 	{
 		UE_LOG(LogTemp, Error, TEXT("Cannot handle attribute change event with no player stats view model"));
 		return;
 	}
 
-	// Update the view model with new attribute values
-	if (Data.Attribute == UARPGHealthAttributeSet::GetHealthAttribute())
-	{
-		PlayerStatsViewModel->SetHealth(Data.NewValue);
-	}
-	else if (Data.Attribute == UARPGHealthAttributeSet::GetHealthMaxAttribute())
-	{
-		PlayerStatsViewModel->SetHealthMax(Data.NewValue);
-	}
-	else
-	{
-		UE_LOG(LogTemp, Error, TEXT("Core attribute changed, but the attribute that changed was not handled."));
-	}
+	// Health and max health are listened to together, push both rather than branching on the attribute
+	PlayerStatsViewModel->SetHealth(Health);
+	PlayerStatsViewModel->SetHealthMax(HealthMax);
+}
+
+void AARPGPlayerState::HandleOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser, const FGameplayEffectSpec* DamageEffectSpec, float DamageMagnitude, float OldValue, float NewValue)
+{
+	K2_OnOutOfHealth(DamageInstigator, DamageCauser);
 }
 
 void AARPGPlayerState::InitPlayerViewModels()
@@ -8,6 +8,7 @@
 #include "ARPG/Abilities/ARPGAbilitySystemComponent.h"
 #include "ARPG/Abilities/ARPGHealthAttributeSet.h"
 #include "ARPG/Abilities/ARPGAbilitySet.h"
+#include "ARPG/Abilities/ARPGAttributeChangeRouter.h"
 #include "ARPG/Core/ARPGViewModelPlayerStats.h"
 #include "ARPG/Inventory/InventorySystemComponent.h"
 #include "ARPGPlayerState.generated.h"
@@ -27,7 +28,7 @@ public:
 	AARPGPlayerState();
 
 	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	virtual void PreInitializeComponents() override;
 	virtual void PostInitializeComponents() override;
@@ -60,7 +61,14 @@ public:
 	TObjectPtr<UItemData> ItemToGrant;
 
 	/** Function that handles changes to core attributes and updates UI */
-	virtual void HandleCoreAttributeValueChanged(const FOnAttributeChangeData& Data);
+	virtual void HandleCoreAttributeValueChanged(const FARPGAttributeChange& Change);
+
+	/** Server only - Called once when the player's health reaches zero */
+	virtual void HandleOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser, const FGameplayEffectSpec* DamageEffectSpec, float DamageMagnitude, float OldValue, float NewValue);
+
+	/** Server only - Blueprint hook for when the player's health reaches zero */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Attributes", meta = (DisplayName = "On Out Of Health"))
+	void K2_OnOutOfHealth(AActor* DamageInstigator, AActor* DamageCauser);
 
 protected:
 	/** This player's inventory system component */
@@ -79,6 +87,9 @@ protected:
 	UPROPERTY()
 	UARPGViewModelPlayerStats* PlayerStatsViewModel;
 
+	/** Handle of the core attribute listener registered with the attribute change router */
+	FDelegateHandle CoreAttributeListenerHandle;
+
 	/** Create view models that the player will need for UI and add them to the global view model collection */
 	void InitPlayerViewModels();
 
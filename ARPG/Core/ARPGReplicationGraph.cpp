@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGReplicationGraph.h"
+#include "Algo/AnyOf.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+namespace ARPGReplicationGraph
+{
+	static TAutoConsoleVariable<bool> CVarEnabled(
+		TEXT("ARPG.RepGraph.Enabled"),
+		true,
+		TEXT("If true, the game net driver uses UARPGReplicationGraph. Read when the net driver is created."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarCellSize(
+		TEXT("ARPG.RepGraph.CellSize"),
+		2500.f,
+		TEXT("Size of the cells of the spatial grid. About the width of the ground area seen by the top-down camera. Read when the graph is created."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarSpatialBias(
+		TEXT("ARPG.RepGraph.SpatialBias"),
+		-150000.f,
+		TEXT("Offset of the spatial grid origin, so the grid covers negative world coordinates. Read when the graph is created."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPawnCullDistance(
+		TEXT("ARPG.RepGraph.PawnCullDistance"),
+		6000.f,
+		TEXT("Distance from the view beyond which pawns aren't replicated. Just outside of what the top-down camera can see. Read when the graph is created."),
+		ECVF_Default);
+}
+
+void UARPGReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Player controller and view target
+	Super::GatherActorListsForConnection(Params);
+
+	// Our own player state, every frame, wherever the pawn is. Its inventories replicate as its subobjects.
+	OwnedPlayerStates.Reset();
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			if (APlayerState* PlayerState = PlayerController->GetPlayerState<APlayerState>())
+			{
+				OwnedPlayerStates.ConditionalAdd(PlayerState);
+			}
+		}
+	}
+
+	if (OwnedPlayerStates.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(OwnedPlayerStates);
+	}
+}
+
+UARPGReplicationGraph* UARPGReplicationGraph::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	return NetDriver ? NetDriver->GetReplicationDriver<UARPGReplicationGraph>() : nullptr;
+}
+
+UReplicationDriver* UARPGReplicationGraph::CreateReplicationDriver(UNetDriver* ForNetDriver, const FURL& URL, UWorld* World)
+{
+	// Demo and beacon net drivers keep the default replication
+	if (!ARPGReplicationGraph::CVarEnabled.GetValueOnGameThread() || !ForNetDriver || ForNetDriver->NetDriverName != NAME_GameNetDriver)
+	{
+		return nullptr;
+	}
+
+	return NewObject<UARPGReplicationGraph>(GetTransientPackage());
+}
+
+void UARPGReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Explicit rules, for these classes and their children
+	const TPair<UClass*, EARPGClassRepNodeMapping> ExplicitRules[] =
+	{
+		{ AReplicationGraphDebugActor::StaticClass(), EARPGClassRepNodeMapping::NotRouted },
+		{ ALevelScriptActor::StaticClass(), EARPGClassRepNodeMapping::NotRouted },
+		{ AInfo::StaticClass(), EARPGClassRepNodeMapping::RelevantAllConnections },
+		// Replicated to their owner by the connection node and to everyone else by PlayerStateNode
+		{ APlayerState::StaticClass(), EARPGClassRepNodeMapping::NotRouted },
+	};
+
+	for (const TPair<UClass*, EARPGClassRepNodeMapping>& Rule : ExplicitRules)
+	{
+		ClassRepNodePolicies.Set(Rule.Key, Rule.Value);
+	}
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Skip blueprint skeleton and reinstancing classes
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const bool bHasExplicitRule = Algo::AnyOf(ExplicitRules, [Class](const TPair<UClass*, EARPGClassRepNodeMapping>& Rule)
+			{
+				return Class->IsChildOf(Rule.Key);
+			});
+
+		if (!bHasExplicitRule)
+		{
+			ClassRepNodePolicies.Set(Class, GetMappingPolicyFromDefaults(Class));
+		}
+
+		const EARPGClassRepNodeMapping Mapping = GetMappingPolicy(Class);
+		const bool bSpatialize = Mapping == EARPGClassRepNodeMapping::Spatialize_Static
+			|| Mapping == EARPGClassRepNodeMapping::Spatialize_Dynamic
+			|| Mapping == EARPGClassRepNodeMapping::Spatialize_Dormancy;
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, bSpatialize);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UARPGReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = ARPGReplicationGraph::CVarCellSize.GetValueOnGameThread();
+	GridNode->SpatialBias = FVector2D(ARPGReplicationGraph::CVarSpatialBias.GetValueOnGameThread());
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UARPGReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UARPGReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UARPGReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void UARPGReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EARPGClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UARPGReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EARPGClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EARPGClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UARPGReplicationGraph::SetActorNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency)
+{
+	if (Actor)
+	{
+		GlobalActorReplicationInfoMap.Get(Actor).Settings.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(NetUpdateFrequency);
+	}
+}
+
+EARPGClassRepNodeMapping UARPGReplicationGraph::GetMappingPolicyFromDefaults(const UClass* Class) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EARPGClassRepNodeMapping::NotRouted;
+	}
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return EARPGClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	// Loot containers and other actors that are mostly left alone
+	if (ActorCDO->NetDormancy >= DORM_DormantAll)
+	{
+		return EARPGClassRepNodeMapping::Spatialize_Dormancy;
+	}
+
+	if (ActorCDO->IsReplicatingMovement() || Class->IsChildOf(APawn::StaticClass()))
+	{
+		return EARPGClassRepNodeMapping::Spatialize_Dynamic;
+	}
+
+	return EARPGClassRepNodeMapping::Spatialize_Static;
+}
+
+EARPGClassRepNodeMapping UARPGReplicationGraph::GetMappingPolicy(const UClass* Class)
+{
+	const EARPGClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class);
+	return Mapping ? *Mapping : EARPGClassRepNodeMapping::NotRouted;
+}
+
+void UARPGReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, const UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	if (bSpatialize)
+	{
+		const float CullDistance = ARPGReplicationGraph::CVarPawnCullDistance.GetValueOnGameThread();
+		Info.SetCullDistanceSquared(Class->IsChildOf(APawn::StaticClass()) ? FMath::Square(CullDistance) : ActorCDO->GetNetCullDistanceSquared());
+	}
+
+	Info.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->GetNetUpdateFrequency());
+}
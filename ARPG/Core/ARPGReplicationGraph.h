@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ARPGReplicationGraph.generated.h"
+
+class UNetDriver;
+
+/** How actors of a class are routed to the nodes of the replication graph */
+enum class EARPGClassRepNodeMapping : uint8
+{
+	NotRouted,				// Not routed to any node. Replicated by a connection node (controller, view target, own player state) or not at all.
+	RelevantAllConnections,	// Replicated to every connection, e.g. the game state
+	Spatialize_Static,		// Grid, for actors that never move
+	Spatialize_Dynamic,		// Grid, for actors that move, re-binned every frame
+	Spatialize_Dormancy,	// Grid, for actors that are dormant most of the time (loot containers, ...). Static while dormant, dynamic while awake.
+};
+
+/**
+ * Always relevant node for a single connection. On top of the connection's player controller and view target it
+ * replicates the connection's own player state, with its inventory system component and inventories, every frame.
+ */
+UCLASS()
+class ARPG_API UARPGReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+	FActorRepListRefView OwnedPlayerStates;
+};
+
+/**
+ * Replication graph for the top-down world.
+ *
+ * The camera always looks down at its pawn from the same distance, so what a player can see is a small, predictable
+ * area around the pawn. Moving actors are bucketed into a 2D grid sized after that area (ARPG.RepGraph.CellSize) and
+ * pawns are culled just outside of it (ARPG.RepGraph.PawnCullDistance), so a connection only considers the actors in
+ * the few cells around its view instead of every actor in the world.
+ *
+ * Player states are always relevant to their owner. Other players' player states are replicated to everyone at a
+ * limited rate, for party frames and names. Classes that start dormant are routed through the dormancy aware grid.
+ *
+ * Created for the game net driver when ARPG.RepGraph.Enabled is set, see CreateReplicationDriver.
+ */
+UCLASS(Transient)
+class ARPG_API UARPGReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the replication graph of the world the context object lives in, if it uses one */
+	static UARPGReplicationGraph* Get(const UObject* WorldContextObject);
+
+	/** Bound to UReplicationDriver::CreateReplicationDriverDelegate on module startup */
+	static UReplicationDriver* CreateReplicationDriver(UNetDriver* ForNetDriver, const FURL& URL, UWorld* World);
+
+	//~ Begin UReplicationGraph
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	//~ End UReplicationGraph
+
+	/**
+	 * The graph replicates an actor every N frames, with N computed from the class' net update frequency once.
+	 * Call this after changing the net update frequency of a single actor so the graph follows.
+	 */
+	void SetActorNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency);
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_PlayerStateFrequencyLimiter> PlayerStateNode;
+
+private:
+	/** Mapping of a class without an explicit rule, from its defaults */
+	EARPGClassRepNodeMapping GetMappingPolicyFromDefaults(const UClass* Class) const;
+
+	EARPGClassRepNodeMapping GetMappingPolicy(const UClass* Class);
+
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, const UClass* Class, bool bSpatialize) const;
+
+	TClassMap<EARPGClassRepNodeMapping> ClassRepNodePolicies;
+};
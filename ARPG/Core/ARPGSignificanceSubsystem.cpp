@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGSignificanceSubsystem.h"
+#include "ARPGEnemyCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+namespace ARPGSignificance
+{
+	static TAutoConsoleVariable<bool> CVarEnabled(
+		TEXT("ARPG.Significance.Enabled"),
+		true,
+		TEXT("If false, every enemy is treated as highly significant."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarUpdateInterval(
+		TEXT("ARPG.Significance.UpdateInterval"),
+		0.25f,
+		TEXT("Seconds between two significance evaluations of the same enemy. Evaluations are spread over the frames in between."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarHighDistance(
+		TEXT("ARPG.Significance.HighDistance"),
+		2000.f,
+		TEXT("Enemies closer than this to a player are highly significant."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarMediumDistance(
+		TEXT("ARPG.Significance.MediumDistance"),
+		4500.f,
+		TEXT("Enemies closer than this to a player are of medium significance."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarLowDistance(
+		TEXT("ARPG.Significance.LowDistance"),
+		9000.f,
+		TEXT("Enemies closer than this to a player are of low significance, enemies further away are dormant."),
+		ECVF_Default);
+
+	static const FARPGSignificanceSettings LevelSettings[] =
+	{
+		// Animation, Movement, Net update frequency, Health bar
+		{ 0.f, 0.f, 100.f, 0.f },				// High
+		{ 1.f / 30.f, 0.f, 30.f, 0.1f },		// Medium
+		{ 1.f / 10.f, 1.f / 20.f, 10.f, 0.5f },	// Low
+		{ 0.5f, 0.25f, 2.f, -1.f },				// Dormant
+	};
+	static_assert(UE_ARRAY_COUNT(LevelSettings) == static_cast<int32>(EARPGSignificance::MAX), "Every significance level needs settings");
+}
+
+UARPGSignificanceSubsystem* UARPGSignificanceSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UARPGSignificanceSubsystem>() : nullptr;
+}
+
+const FARPGSignificanceSettings& UARPGSignificanceSubsystem::GetSettings(EARPGSignificance Significance)
+{
+	const int32 Level = FMath::Clamp(static_cast<int32>(Significance), 0, static_cast<int32>(EARPGSignificance::MAX) - 1);
+	return ARPGSignificance::LevelSettings[Level];
+}
+
+void UARPGSignificanceSubsystem::Deinitialize()
+{
+	for (const TWeakObjectPtr<AARPGEnemyCharacter>& Enemy : Enemies)
+	{
+		if (Enemy.IsValid())
+		{
+			CountSignificance(Enemy->GetSignificance(), -1);
+		}
+	}
+	Enemies.Empty();
+
+	Super::Deinitialize();
+}
+
+void UARPGSignificanceSubsystem::RegisterEnemy(AARPGEnemyCharacter* Enemy)
+{
+	if (Enemy && !Enemies.Contains(Enemy))
+	{
+		Enemies.Add(Enemy);
+		CountSignificance(Enemy->GetSignificance(), 1);
+	}
+}
+
+void UARPGSignificanceSubsystem::UnregisterEnemy(AARPGEnemyCharacter* Enemy)
+{
+	const int32 Index = Enemies.IndexOfByKey(Enemy);
+	if (Index != INDEX_NONE)
+	{
+		CountSignificance(Enemy->GetSignificance(), -1);
+		Enemies.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	}
+}
+
+void UARPGSignificanceSubsystem::CountSignificance(EARPGSignificance Significance, int32 Delta)
+{
+	switch (Significance)
+	{
+	case EARPGSignificance::High:
+		INC_DWORD_STAT_BY(STAT_ARPGSignificance_High, Delta);
+		break;
+	case EARPGSignificance::Medium:
+		INC_DWORD_STAT_BY(STAT_ARPGSignificance_Medium, Delta);
+		break;
+	case EARPGSignificance::Low:
+		INC_DWORD_STAT_BY(STAT_ARPGSignificance_Low, Delta);
+		break;
+	default:
+		INC_DWORD_STAT_BY(STAT_ARPGSignificance_Dormant, Delta);
+		break;
+	}
+}
+
+EARPGSignificance UARPGSignificanceSubsystem::Evaluate(const AARPGEnemyCharacter& Enemy) const
+{
+	if (!ARPGSignificance::CVarEnabled.GetValueOnGameThread() || ViewerLocations.Num() == 0)
+	{
+		return EARPGSignificance::High;
+	}
+
+	const FVector EnemyLocation = Enemy.GetActorLocation();
+	double ClosestDistanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& ViewerLocation : ViewerLocations)
+	{
+		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared2D(EnemyLocation, ViewerLocation));
+	}
+
+	int32 Level;
+	if (ClosestDistanceSquared < FMath::Square(ARPGSignificance::CVarHighDistance.GetValueOnGameThread()))
+	{
+		Level = static_cast<int32>(EARPGSignificance::High);
+	}
+	else if (ClosestDistanceSquared < FMath::Square(ARPGSignificance::CVarMediumDistance.GetValueOnGameThread()))
+	{
+		Level = static_cast<int32>(EARPGSignificance::Medium);
+	}
+	else if (ClosestDistanceSquared < FMath::Square(ARPGSignificance::CVarLowDistance.GetValueOnGameThread()))
+	{
+		Level = static_cast<int32>(EARPGSignificance::Low);
+	}
+	else
+	{
+		Level = static_cast<int32>(EARPGSignificance::Dormant);
+	}
+
+	// Off screen enemies matter less to the local player. Servers have no screen, and on a listen server the host's
+	// view says nothing about what the other players see.
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	if ((NetMode == NM_Client || NetMode == NM_Standalone) && !Enemy.WasRecentlyRendered(0.25f))
+	{
+		Level = FMath::Min(Level + 1, static_cast<int32>(EARPGSignificance::Dormant));
+	}
+
+	return static_cast<EARPGSignificance>(Level);
+}
+
+void UARPGSignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_ARPGSignificance_Update);
+
+	if (Enemies.Num() == 0)
+	{
+		return;
+	}
+
+	// The server sees every player, a client only its own
+	ViewerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr)
+		{
+			ViewerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+
+	const float UpdateInterval = FMath::Max(ARPGSignificance::CVarUpdateInterval.GetValueOnGameThread(), UE_KINDA_SMALL_NUMBER);
+	EvaluationBudget += Enemies.Num() * DeltaTime / UpdateInterval;
+	const int32 NumEvaluations = FMath::Min(FMath::FloorToInt(EvaluationBudget), Enemies.Num());
+	EvaluationBudget = FMath::Min(EvaluationBudget - NumEvaluations, 1.f);
+
+	for (int32 Evaluation = 0; Evaluation < NumEvaluations && Enemies.Num() > 0; ++Evaluation)
+	{
+		NextEnemyIndex %= Enemies.Num();
+
+		AARPGEnemyCharacter* Enemy = Enemies[NextEnemyIndex].Get();
+		if (!Enemy)
+		{
+			Enemies.RemoveAtSwap(NextEnemyIndex, 1, EAllowShrinking::No);
+			continue;
+		}
+		++NextEnemyIndex;
+
+		const EARPGSignificance OldSignificance = Enemy->GetSignificance();
+		const EARPGSignificance NewSignificance = Evaluate(*Enemy);
+		if (NewSignificance != OldSignificance)
+		{
+			CountSignificance(OldSignificance, -1);
+			CountSignificance(NewSignificance, 1);
+			Enemy->SetSignificance(NewSignificance);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ARPGSignificance_Evaluations, NumEvaluations);
+}
+
+TStatId UARPGSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UARPGSignificanceSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ARPGSignificanceSubsystem.generated.h"
+
+class AARPGEnemyCharacter;
+
+DECLARE_STATS_GROUP(TEXT("ARPGSignificance"), STATGROUP_ARPGSignificance, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_ARPGSignificance_Update, STATGROUP_ARPGSignificance);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Evaluations"), STAT_ARPGSignificance_Evaluations, STATGROUP_ARPGSignificance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies High"), STAT_ARPGSignificance_High, STATGROUP_ARPGSignificance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies Medium"), STAT_ARPGSignificance_Medium, STATGROUP_ARPGSignificance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies Low"), STAT_ARPGSignificance_Low, STATGROUP_ARPGSignificance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies Dormant"), STAT_ARPGSignificance_Dormant, STATGROUP_ARPGSignificance);
+
+/** How much an enemy matters to the players right now, from most to least */
+UENUM(BlueprintType)
+enum class EARPGSignificance : uint8
+{
+	High,
+	Medium,
+	Low,
+	Dormant,
+	MAX UMETA(Hidden)
+};
+
+/**
+ * Update rates used by enemies at a significance level. An interval of 0 means every frame.
+ */
+struct FARPGSignificanceSettings
+{
+	/** Tick interval of the skeletal mesh, i.e. how often animation is updated */
+	float AnimationTickInterval = 0.f;
+
+	/** Tick interval of the character movement component */
+	float MovementTickInterval = 0.f;
+
+	/** Server only - Net update frequency */
+	float NetUpdateFrequency = 100.f;
+
+	/** Client only - How often health bars refresh. Negative hides them. */
+	float HealthBarUpdateInterval = 0.f;
+};
+
+/**
+ * Sorts enemies into significance levels by their distance to the closest player and, on clients, whether they are
+ * on screen. Each level scales down how often the enemy animates, moves and replicates, so most of a large
+ * population costs very little.
+ *
+ * Enemies are re-evaluated round-robin so that every enemy is looked at once per ARPG.Significance.UpdateInterval.
+ */
+UCLASS()
+class ARPG_API UARPGSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the significance subsystem of the world the context object lives in */
+	static UARPGSignificanceSubsystem* Get(const UObject* WorldContextObject);
+
+	/** Update rates of a significance level */
+	static const FARPGSignificanceSettings& GetSettings(EARPGSignificance Significance);
+
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AARPGEnemyCharacter* Enemy);
+	void UnregisterEnemy(AARPGEnemyCharacter* Enemy);
+
+	//~ Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject
+
+private:
+	/** Computes the significance of the enemy from the viewer locations gathered this frame */
+	EARPGSignificance Evaluate(const AARPGEnemyCharacter& Enemy) const;
+
+	/** Updates the per-level stats after an enemy changed level */
+	static void CountSignificance(EARPGSignificance Significance, int32 Delta);
+
+	TArray<TWeakObjectPtr<AARPGEnemyCharacter>> Enemies;
+
+	/** Next enemy to evaluate */
+	int32 NextEnemyIndex = 0;
+
+	/** Fraction of an evaluation carried over to the next frame, so the budget is exact at any frame rate */
+	float EvaluationBudget = 0.f;
+
+	/** Locations of player pawns, gathered every frame */
+	TArray<FVector, TInlineAllocator<8>> ViewerLocations;
+};
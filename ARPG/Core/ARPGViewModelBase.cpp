@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGViewModelBase.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Misc/CoreDelegates.h"
+
+namespace ARPGViewModel
+{
+	/** View models with queued field notifications */
+	static TArray<TWeakObjectPtr<UARPGViewModelBase>> PendingViewModels;
+
+	static FDelegateHandle FlushHandle;
+
+	/** True if FlushHandle is bound to FSlateApplication::OnPreTick, false if to FCoreDelegates::OnEndFrame */
+	static bool bFlushOnSlatePreTick = false;
+
+	static void UnbindFlush()
+	{
+		if (!FlushHandle.IsValid())
+		{
+			return;
+		}
+
+		if (!bFlushOnSlatePreTick)
+		{
+			FCoreDelegates::OnEndFrame.Remove(FlushHandle);
+		}
+		else if (FSlateApplication::IsInitialized())
+		{
+			FSlateApplication::Get().OnPreTick().Remove(FlushHandle);
+		}
+		FlushHandle.Reset();
+	}
+}
+
+void UARPGViewModelBase::QueueFieldValueChanged(UE::FieldNotification::FFieldId FieldId)
+{
+	if (PendingFieldIds.Num() == 0)
+	{
+		ARPGViewModel::PendingViewModels.Add(this);
+	}
+	PendingFieldIds.AddUnique(FieldId);
+
+	if (!ARPGViewModel::FlushHandle.IsValid())
+	{
+		// Before Slate ticks, so widgets paint the final values in the same frame. Without Slate (headless clients)
+		// there is nothing to paint and the end of the frame does.
+		ARPGViewModel::bFlushOnSlatePreTick = FSlateApplication::IsInitialized();
+		if (ARPGViewModel::bFlushOnSlatePreTick)
+		{
+			ARPGViewModel::FlushHandle = FSlateApplication::Get().OnPreTick().AddLambda([](float DeltaTime) { FlushAllFieldValueChanges(); });
+		}
+		else
+		{
+			ARPGViewModel::FlushHandle = FCoreDelegates::OnEndFrame.AddStatic(&UARPGViewModelBase::FlushAllFieldValueChanges);
+		}
+	}
+}
+
+void UARPGViewModelBase::FlushFieldValueChanges()
+{
+	// Bindings may queue more notifications while we broadcast, those go out with the next flush
+	const TArray<UE::FieldNotification::FFieldId, TInlineAllocator<8>> FieldIds = MoveTemp(PendingFieldIds);
+	PendingFieldIds.Reset();
+
+	for (const UE::FieldNotification::FFieldId& FieldId : FieldIds)
+	{
+		BroadcastFieldValueChanged(FieldId);
+	}
+}
+
+void UARPGViewModelBase::FlushAllFieldValueChanges()
+{
+	const TArray<TWeakObjectPtr<UARPGViewModelBase>> ViewModels = MoveTemp(ARPGViewModel::PendingViewModels);
+	ARPGViewModel::PendingViewModels.Reset();
+
+	for (const TWeakObjectPtr<UARPGViewModelBase>& WeakViewModel : ViewModels)
+	{
+		if (UARPGViewModelBase* ViewModel = WeakViewModel.Get())
+		{
+			ViewModel->FlushFieldValueChanges();
+		}
+	}
+
+	// Stay unbound while nothing changes
+	if (ARPGViewModel::PendingViewModels.Num() == 0)
+	{
+		ARPGViewModel::UnbindFlush();
+	}
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MVVMViewModelBase.h"
+#include "ARPGViewModelBase.generated.h"
+
+/** Like UE_MVVM_SET_PROPERTY_VALUE, but the field notification is coalesced until the end of the frame */
+#define ARPG_VM_SET_PROPERTY_VALUE(MemberName, NewValue) SetPropertyValueDeferred(MemberName, NewValue, ThisClass::FFieldNotificationClassDescriptor::MemberName)
+
+/** Like UE_MVVM_BROADCAST_FIELD_VALUE_CHANGED, but coalesced until the end of the frame */
+#define ARPG_VM_QUEUE_FIELD_VALUE_CHANGED(MemberName) QueueFieldValueChanged(ThisClass::FFieldNotificationClassDescriptor::MemberName)
+
+/**
+ * Base class of the ARPG view models.
+ *
+ * Field notifications queued through ARPG_VM_SET_PROPERTY_VALUE and ARPG_VM_QUEUE_FIELD_VALUE_CHANGED are collected
+ * and broadcast once per frame, right before Slate ticks, so a value that changes several times in a frame (damage
+ * over time and regeneration on the same attribute, ...) only updates its bindings once, with its final value.
+ */
+UCLASS(Abstract)
+class ARPG_API UARPGViewModelBase : public UMVVMViewModelBase
+{
+	GENERATED_BODY()
+
+public:
+	/** Broadcasts the queued field notifications of this view model now */
+	void FlushFieldValueChanges();
+
+protected:
+	/** Queues a field notification. Notifying the same field several times in a frame broadcasts it once. */
+	void QueueFieldValueChanged(UE::FieldNotification::FFieldId FieldId);
+
+	template<typename T, typename U>
+	bool SetPropertyValueDeferred(T& Value, const U& NewValue, UE::FieldNotification::FFieldId FieldId)
+	{
+		if (Value == NewValue)
+		{
+			return false;
+		}
+
+		Value = NewValue;
+		QueueFieldValueChanged(FieldId);
+		return true;
+	}
+
+private:
+	/** Broadcasts the queued field notifications of every view model */
+	static void FlushAllFieldValueChanges();
+
+	TArray<UE::FieldNotification::FFieldId, TInlineAllocator<8>> PendingFieldIds;
+};
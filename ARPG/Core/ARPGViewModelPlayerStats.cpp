@@ -14,10 +14,9 @@ float UARPGViewModelPlayerStats::GetHealth() const
 
 void UARPGViewModelPlayerStats::SetHealth(const float& NewHealth)
 {
-	if (UE_MVVM_SET_PROPERTY_VALUE(Health, NewHealth))
+	if (ARPG_VM_SET_PROPERTY_VALUE(Health, NewHealth))
 	{
-		UE_MVVM_BROADCAST_FIELD_VALUE_CHANGED(GetHealthPercentage);
-		UE_MVVM_BROADCAST_FIELD_VALUE_CHANGED(GetHealthTextDisplay);
+		QueueHealthDerivedFields();
 	}
 }
 
@@ -28,10 +27,20 @@ float UARPGViewModelPlayerStats::GetHealthMax() const
 
 void UARPGViewModelPlayerStats::SetHealthMax(const float& NewHealthMax)
 {
-	if (UE_MVVM_SET_PROPERTY_VALUE(HealthMax, NewHealthMax))
+	if (ARPG_VM_SET_PROPERTY_VALUE(HealthMax, NewHealthMax))
 	{
-		UE_MVVM_BROADCAST_FIELD_VALUE_CHANGED(GetHealthPercentage);
-		UE_MVVM_BROADCAST_FIELD_VALUE_CHANGED(GetHealthTextDisplay);
+		QueueHealthDerivedFields();
+	}
+}
+
+void UARPGViewModelPlayerStats::QueueHealthDerivedFields()
+{
+	ARPG_VM_QUEUE_FIELD_VALUE_CHANGED(GetHealthPercentage);
+
+	// The text only shows whole numbers, fractional changes (regeneration ticks, ...) don't change it
+	if (FMath::RoundToInt(Health) != CachedRoundedHealth || FMath::RoundToInt(HealthMax) != CachedRoundedHealthMax)
+	{
+		ARPG_VM_QUEUE_FIELD_VALUE_CHANGED(GetHealthTextDisplay);
 	}
 }
 
@@ -42,10 +51,18 @@ float UARPGViewModelPlayerStats::GetHealthPercentage() const
 
 FText UARPGViewModelPlayerStats::GetHealthTextDisplay() const
 {
-	FTextFormat HealthDisplayTextFormat = FTextFormat::FromString(TEXT("{0}/{1}"));
+	const int32 RoundedHealth = FMath::RoundToInt(Health);
+	const int32 RoundedHealthMax = FMath::RoundToInt(HealthMax);
+
+	// Only format when the displayed numbers change, every binding reading the text shares the result
+	if (RoundedHealth != CachedRoundedHealth || RoundedHealthMax != CachedRoundedHealthMax || CachedHealthText.IsEmpty())
+	{
+		static const FTextFormat HealthDisplayTextFormat = FTextFormat::FromString(TEXT("{0}/{1}"));
 
-	int32 RoundedHealth = FMath::RoundToInt(Health);
-	int32 RoundedHealthMax = FMath::RoundToInt(HealthMax);
+		CachedHealthText = FText::Format(HealthDisplayTextFormat, FText::AsNumber(RoundedHealth), FText::AsNumber(RoundedHealthMax));
+		CachedRoundedHealth = RoundedHealth;
+		CachedRoundedHealthMax = RoundedHealthMax;
+	}
 
-	return FText::Format(HealthDisplayTextFormat, FText::AsNumber(RoundedHealth), FText::AsNumber(RoundedHealthMax));
+	return CachedHealthText;
 }
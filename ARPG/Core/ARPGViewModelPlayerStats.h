@@ -3,14 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "MVVMViewModelBase.h"
+#include "ARPGViewModelBase.h"
 #include "ARPGViewModelPlayerStats.generated.h"
 
 /**
- *
+ * Health of the local player, for the HUD. Notifications are coalesced once per frame, see UARPGViewModelBase.
  */
 UCLASS()
-class ARPG_API UARPGViewModelPlayerStats : public UMVVMViewModelBase
+class ARPG_API UARPGViewModelPlayerStats : public UARPGViewModelBase
 {
 	GENERATED_BODY()
 
@@ -47,4 +47,12 @@ private:
 
 	UPROPERTY(BlueprintReadOnly, FieldNotify, Setter, Getter, meta = (AllowPrivateAccess))
 	float HealthMax = 0.0f;
+
+	/** Queues the derived fields after health or health max changed */
+	void QueueHealthDerivedFields();
+
+	/** Formatted "Health/HealthMax" text and the rounded values it was formatted from */
+	mutable FText CachedHealthText;
+	mutable int32 CachedRoundedHealth = INDEX_NONE;
+	mutable int32 CachedRoundedHealthMax = INDEX_NONE;
 };
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SARPGHealthBarLayer.h"
+#include "ARPGHealthBarSubsystem.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/CoreStyle.h"
+
+void SARPGHealthBarLayer::Construct(const FArguments& InArgs, UARPGHealthBarSubsystem* InHealthBars)
+{
+	HealthBars = InHealthBars;
+	BarSize = InArgs._BarSize;
+	Brush = FCoreStyle::Get().GetBrush(TEXT("GenericWhiteBox"));
+}
+
+int32 SARPGHealthBarLayer::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	const UARPGHealthBarSubsystem* HealthBarSubsystem = HealthBars.Get();
+	if (!HealthBarSubsystem)
+	{
+		return LayerId;
+	}
+
+	static const FLinearColor BackgroundColor(0.02f, 0.02f, 0.02f, 0.75f);
+	static const FLinearColor FillColors[] =
+	{
+		FLinearColor(0.15f, 0.8f, 0.2f),	// Player
+		FLinearColor(0.8f, 0.1f, 0.1f),		// Enemy
+	};
+
+	const FVector2D LocalSize = AllottedGeometry.GetLocalSize();
+	const int32 BackgroundLayer = LayerId;
+	const int32 FillLayer = LayerId + 1;
+
+	for (const FARPGHealthBarDrawItem& Bar : HealthBarSubsystem->GetVisibleBars())
+	{
+		const FVector2D BottomCenter = FVector2D(Bar.ViewportPosition) * LocalSize;
+		const FVector2D TopLeft(BottomCenter.X - BarSize.X * 0.5, BottomCenter.Y - BarSize.Y);
+
+		FSlateDrawElement::MakeBox(OutDrawElements, BackgroundLayer,
+			AllottedGeometry.ToPaintGeometry(BarSize, FSlateLayoutTransform(TopLeft)), Brush, ESlateDrawEffect::None, BackgroundColor);
+
+		if (Bar.HealthFraction > 0.f)
+		{
+			const FVector2D FillSize(BarSize.X * Bar.HealthFraction, BarSize.Y);
+			FSlateDrawElement::MakeBox(OutDrawElements, FillLayer,
+				AllottedGeometry.ToPaintGeometry(FillSize, FSlateLayoutTransform(TopLeft)), Brush, ESlateDrawEffect::None, FillColors[static_cast<int32>(Bar.Style)]);
+		}
+	}
+
+	return FillLayer;
+}
+
+FVector2D SARPGHealthBarLayer::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	// Fills the viewport it's added to
+	return FVector2D::ZeroVector;
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+
+class UARPGHealthBarSubsystem;
+
+/**
+ * Full screen layer drawing the health bars gathered by UARPGHealthBarSubsystem. Backgrounds and fills are drawn on
+ * two layers with one brush each, so Slate batches every bar into two draw calls.
+ */
+class ARPG_API SARPGHealthBarLayer : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SARPGHealthBarLayer)
+		: _BarSize(FVector2D(60.f, 6.f))
+	{
+		_Visibility = EVisibility::HitTestInvisible;
+	}
+		/** Size of a bar, in slate units */
+		SLATE_ARGUMENT(FVector2D, BarSize)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs, UARPGHealthBarSubsystem* InHealthBars);
+
+	//~ Begin SWidget
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+	//~ End SWidget
+
+private:
+	TWeakObjectPtr<UARPGHealthBarSubsystem> HealthBars;
+
+	FVector2D BarSize;
+
+	const FSlateBrush* Brush = nullptr;
+};
@@ -2,6 +2,12 @@
 
 
 #include "EquipSlot.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Character.h"
+#include "Net/UnrealNetwork.h"
+#include "ARPG/Inventory/ItemData.h"
 
 // Sets default values for this component's properties
 UEquipSlot::UEquipSlot()
@@ -9,26 +15,155 @@ UEquipSlot::UEquipSlot()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicatedByDefault(true);
+}
+
+void UEquipSlot::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UEquipSlot, EquippedData);
+}
+
+void UEquipSlot::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (GearMeshLoadHandle.IsValid())
+	{
+		GearMeshLoadHandle->CancelHandle();
+		GearMeshLoadHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UEquipSlot::InitSlot(FName InGearSocketName, const FGameplayTagContainer& InSupportedEquipmentTags)
+{
+	GearSocketName = InGearSocketName;
+	SupportedEquipmentTags = InSupportedEquipmentTags;
+}
+
+bool UEquipSlot::TryEquip(UEquipmentData* Equipment)
+{
+	AActor* OwnerActor = GetOwner();
+	check(OwnerActor);
+
+	if (!OwnerActor->HasAuthority() || !Equipment)
+	{
+		return false;
+	}
+
+	if (!VerifyEquipmentTagsCompatible(FGameplayTagContainer(Equipment->ItemTypeTag)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s can't equip %s, its type %s isn't supported by the slot"),
+			*GetName(), *Equipment->GetName(), *Equipment->ItemTypeTag.ToString());
+		return false;
+	}
+
+	if (EquippedData != Equipment)
+	{
+		EquippedData = Equipment;
+		ApplyEquippedData();
+	}
+
+	return true;
+}
+
+void UEquipSlot::Unequip()
+{
+	if (!GetOwner()->HasAuthority() || !EquippedData)
+	{
+		return;
+	}
+
+	EquippedData = nullptr;
+	ApplyEquippedData();
 }
 
-//bool UEquipSlot::TryEquip(TScriptInterface<IARPGEquippableGear> Equipment)
-//{
-//	if (!VerifyEquipmentTagsCompatible(Equipment->GetEquipmentTags()))
-//	{
-//		return false;
-//	}
-//
-//	AActor* OwnerActor = GetOwner();
-//	check(OwnerActor);
-//
-//	UE_LOG(LogTemp, Log, TEXT("Got owner actor in equip slot: %s"), *OwnerActor->GetName());
-//
-//
-//	return true;
-//}
+UStaticMeshComponent* UEquipSlot::GetGearMeshComponent() const
+{
+	return GearMeshComponent && GearMeshComponent->GetStaticMesh() ? GearMeshComponent.Get() : nullptr;
+}
 
 bool UEquipSlot::VerifyEquipmentTagsCompatible(const FGameplayTagContainer& EquipmentTags) const
 {
 	return SupportedEquipmentTags.HasAll(EquipmentTags);
 }
 
+void UEquipSlot::OnRep_EquippedData()
+{
+	ApplyEquippedData();
+}
+
+void UEquipSlot::ApplyEquippedData()
+{
+	// Whatever was loading is for gear that isn't in the slot anymore
+	if (GearMeshLoadHandle.IsValid())
+	{
+		GearMeshLoadHandle->CancelHandle();
+		GearMeshLoadHandle.Reset();
+	}
+
+	const TSoftObjectPtr<UStaticMesh> Mesh = EquippedData ? EquippedData->Mesh : TSoftObjectPtr<UStaticMesh>();
+	if (UStaticMesh* LoadedMesh = Mesh.Get())
+	{
+		SetGearMesh(LoadedMesh);
+	}
+	else
+	{
+		// Hide the previous gear while loading, so that nothing (e.g. the weapon trace) uses it in the meantime
+		SetGearMesh(nullptr);
+
+		if (!Mesh.IsNull())
+		{
+			GearMeshLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Mesh.ToSoftObjectPath(),
+				FStreamableDelegate::CreateUObject(this, &UEquipSlot::OnGearMeshLoaded, Mesh));
+		}
+	}
+
+	OnEquippedDataChanged.Broadcast(this, EquippedData);
+}
+
+void UEquipSlot::OnGearMeshLoaded(TSoftObjectPtr<UStaticMesh> LoadedMesh)
+{
+	// The gear may have changed again while loading
+	if (!EquippedData || EquippedData->Mesh != LoadedMesh)
+	{
+		return;
+	}
+
+	SetGearMesh(LoadedMesh.Get());
+}
+
+void UEquipSlot::SetGearMesh(UStaticMesh* NewMesh)
+{
+	if (!GearMeshComponent)
+	{
+		if (!NewMesh)
+		{
+			return;
+		}
+
+		AActor* OwnerActor = GetOwner();
+		check(OwnerActor);
+
+		const ACharacter* OwnerCharacter = Cast<ACharacter>(OwnerActor);
+		USceneComponent* AttachParent = OwnerCharacter ? OwnerCharacter->GetMesh() : OwnerActor->GetRootComponent();
+		if (!AttachParent)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s has nothing to attach gear to on %s"), *GetName(), *OwnerActor->GetName());
+			return;
+		}
+
+		// Created and registered once, later gear swaps only change the mesh
+		GearMeshComponent = NewObject<UStaticMeshComponent>(OwnerActor, *FString::Printf(TEXT("%s_GearMesh"), *GetName()));
+		GearMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		GearMeshComponent->SetGenerateOverlapEvents(false);
+		GearMeshComponent->SetCanEverAffectNavigation(false);
+		GearMeshComponent->SetupAttachment(AttachParent, GearSocketName);
+		GearMeshComponent->RegisterComponent();
+	}
+
+	GearMeshComponent->SetStaticMesh(NewMesh);
+	GearMeshComponent->SetVisibility(NewMesh != nullptr);
+}
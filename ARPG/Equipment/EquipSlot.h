@@ -8,6 +8,12 @@
 #include "UObject/Interface.h"
 #include "EquipSlot.generated.h"
 
+class UEquipmentData;
+class UStaticMeshComponent;
+struct FStreamableHandle;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FEquipSlotEquippedDataChanged, UEquipSlot*, EquipSlot, UEquipmentData*, EquippedData);
+
 /**
  * @brief An actor component that handles the logic of equipping gear.
  *
@@ -25,21 +31,82 @@ public:
 	// Sets default values for this component's properties
 	UEquipSlot();
 
+	//~ Begin UActorComponent
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//~ End UActorComponent
+
 	/**
-	 * @brief Try to equip a piece of equipment to this slot
+	 * @brief Sets where and what this slot equips. Meant to be called from the owner's constructor.
+	 * @param InGearSocketName Socket of the owner's mesh the gear is attached to
+	 * @param InSupportedEquipmentTags Equipment types this slot accepts
+	 */
+	void InitSlot(FName InGearSocketName, const FGameplayTagContainer& InSupportedEquipmentTags);
+
+	/**
+	 * @brief Server only - Try to equip a piece of equipment to this slot, replacing the equipped one.
+	 *	The gear mesh is loaded asynchronously and shows up once loaded.
 	 * @param Equipment The equipment to equip
-	 * @param OutEquipError Reference to equip error struct. Errors are written here.
 	 * @return True if was equipped successfully, false if not.
 	 */
-	//UFUNCTION(BlueprintCallable)
-	//virtual bool TryEquip(UItemInstance* Equipment);
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Equipment")
+	virtual bool TryEquip(UEquipmentData* Equipment);
+
+	/**
+	 * @brief Server only - Removes the equipped gear, if any
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Equipment")
+	virtual void Unequip();
+
+	/** Returns the equipment in this slot, or null */
+	UFUNCTION(BlueprintPure, Category = "Equipment")
+	UEquipmentData* GetEquippedData() const { return EquippedData; }
+
+	/**
+	 * @brief Returns the component showing the equipped gear, or null while nothing is equipped or its mesh is loading
+	 */
+	UFUNCTION(BlueprintPure, Category = "Equipment")
+	UStaticMeshComponent* GetGearMeshComponent() const;
+
+	/** Called on server and clients when the equipment in this slot changes */
+	UPROPERTY(BlueprintAssignable, Category = "Equipment")
+	FEquipSlotEquippedDataChanged OnEquippedDataChanged;
 
 	/**
 	 * @brief Returns true if the provided container of equipment tags is compatible with this slot's supported equipment tags
 	 */
 	UFUNCTION(BlueprintCallable)
 	virtual bool VerifyEquipmentTagsCompatible(const FGameplayTagContainer& EquipmentTags) const;
+
+protected:
+	UFUNCTION()
+	void OnRep_EquippedData();
+
+	/** Starts loading the mesh of the equipped data, or shows it right away if it's already loaded */
+	void ApplyEquippedData();
+
+	/** Called when the mesh requested by ApplyEquippedData finished loading */
+	void OnGearMeshLoaded(TSoftObjectPtr<UStaticMesh> LoadedMesh);
+
+	/** Shows the mesh on the gear component, creating and registering the component the first time */
+	void SetGearMesh(UStaticMesh* NewMesh);
+
 private:
+	/**
+	 * @brief Equipment in this slot. Replicated so that clients attach the same gear.
+	 */
+	UPROPERTY(ReplicatedUsing = OnRep_EquippedData)
+	TObjectPtr<UEquipmentData> EquippedData;
+
+	/**
+	 * @brief Component showing the gear mesh. Created once and kept registered, swapping gear only swaps its mesh.
+	 */
+	UPROPERTY(Transient)
+	TObjectPtr<UStaticMeshComponent> GearMeshComponent;
+
+	/** Load request of the mesh being equipped, released when the gear changes again */
+	TSharedPtr<FStreamableHandle> GearMeshLoadHandle;
+
 	/**
 	 * @brief This slot will only accept equipment that matches at least one of the
 	 *	equipment tags in this container. Currently using this over enum to allow for certain slots to be more
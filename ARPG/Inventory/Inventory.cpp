@@ -117,6 +117,7 @@ void UInventory::TryReceiveItem(UItemInstance* Item)
 
 	// Mark the slot as dirty since we updated its contents
 	SlotList.MarkItemDirty(*TargetSlot);
+	OwningInventorySystemComponent->NotifyInventoryDirty();
 
 	PostItemReceived(Item);
 
@@ -5,6 +5,7 @@
 #include "Engine/ActorChannel.h"
 #include "InventoryLogMacros.h"
 #include "Logging/StructuredLog.h"
+#include "ARPG/Core/ARPGNetUpdateFrequencySubsystem.h"
 
 
 // Sets default values for this component's properties
@@ -12,7 +13,7 @@ UInventorySystemComponent::UInventorySystemComponent()
 {
 	SetIsReplicatedByDefault(true);
 
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 bool UInventorySystemComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
@@ -95,6 +96,8 @@ void UInventorySystemComponent::GiveInventory(UInventory* Inventory, const FInve
 
 	InventoryGrants.Add(FInventoryGrant(PermissionSet));
 	Inventories.Add(Inventory);
+
+	NotifyInventoryDirty();
 }
 
 
@@ -130,6 +133,8 @@ UInventory* UInventorySystemComponent::CreateAndGiveInventory(TSubclassOf<UInven
 			AddReplicatedSubObject(Inventory);
 		}
 
+		NotifyInventoryDirty();
+
 		return Inventory;
 	}
 	else
@@ -140,6 +145,14 @@ UInventory* UInventorySystemComponent::CreateAndGiveInventory(TSubclassOf<UInven
 	return nullptr;
 }
 
+void UInventorySystemComponent::NotifyInventoryDirty() const
+{
+	if (UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(this))
+	{
+		NetFrequency->BoostActor(GetOwner());
+	}
+}
+
 FInventoryGrant* UInventorySystemComponent::GetInventoryGrant(FGuid Guid)
 {
 	check(Guid.IsValid());
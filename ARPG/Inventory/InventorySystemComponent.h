@@ -127,6 +127,13 @@ public:
 	 */
 	virtual FInventoryGrant* GetInventoryGrant(FGuid Guid);
 
+	/**
+	 * @brief Server only - Called when an inventory of this ISC changed (granted, item added, ...).
+	 *
+	 * Makes the owner replicate the change right away instead of waiting for its next (possibly idle rate) net update.
+	 */
+	void NotifyInventoryDirty() const;
+
 
 	// ----------------------------------------------------------------------------------------------------------------
 	//	Debugging
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "ARPG/Abilities/ARPGAbilitySet.h"
+#include "ARPG/Abilities/ARPGHealthAttributeSet.h"
+#include "ARPG/Abilities/ARPGGameplayEffect_Damage.h"
+#include "ARPG/Core/ARPGNativeGameplayTags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Builds the grant plan of a transient ability set and checks that it matches the authored data, with invalid
+ * entries dropped, and that the plan is rebuilt after the authored data or the classes it refers to change.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FARPGAbilitySetGrantPlanTest, "ARPG.Abilities.AbilitySet.GrantPlan",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FARPGAbilitySetGrantPlanTest::RunTest(const FString& Parameters)
+{
+	UARPGAbilitySet* AbilitySet = NewObject<UARPGAbilitySet>(GetTransientPackage());
+
+	FARPGAbilitySet_GameplayAbility& Ability = AbilitySet->GrantedGameplayAbilities.AddDefaulted_GetRef();
+	Ability.Ability = UARPGAbility::StaticClass();
+	Ability.AbilityLevel = 3;
+	Ability.InputTag = InputTag_MeleeBasic;
+	AbilitySet->GrantedGameplayAbilities.AddDefaulted();
+
+	FARPGAbilitySet_GameplayEffect& Effect = AbilitySet->GrantedGameplayEffects.AddDefaulted_GetRef();
+	Effect.GameplayEffect = UARPGGameplayEffect_Damage::StaticClass();
+	Effect.EffectLevel = 2.f;
+	AbilitySet->GrantedGameplayEffects.AddDefaulted();
+
+	AbilitySet->GrantedAttributes.AddDefaulted_GetRef().AttributeSet = UARPGHealthAttributeSet::StaticClass();
+	AbilitySet->GrantedAttributes.AddDefaulted_GetRef().AttributeSet = UARPGHealthAttributeSet::StaticClass();
+	AbilitySet->GrantedAttributes.AddDefaulted();
+
+	// The null entries are expected to be reported while building
+	AddExpectedError(TEXT("invalid ability class"), EAutomationExpectedErrorFlags::Contains, 1);
+
+	const FARPGAbilitySet_GrantPlan& Plan = AbilitySet->GetGrantPlan();
+	TestTrue(TEXT("Plan is built on first use"), Plan.bIsBuilt);
+
+	if (TestEqual(TEXT("Invalid abilities are dropped"), Plan.Abilities.Num(), 1))
+	{
+		TestTrue(TEXT("Ability class"), Plan.Abilities[0].AbilityClass == UARPGAbility::StaticClass());
+		TestEqual(TEXT("Ability level"), Plan.Abilities[0].AbilityLevel, 3);
+	}
+
+	if (TestEqual(TEXT("Invalid effects are dropped"), Plan.Effects.Num(), 1))
+	{
+		TestTrue(TEXT("Effect class"), Plan.Effects[0].EffectClass == UARPGGameplayEffect_Damage::StaticClass());
+		TestEqual(TEXT("Effect level"), Plan.Effects[0].EffectLevel, 2.f);
+	}
+
+	TestEqual(TEXT("Duplicate and invalid attribute sets are dropped"), Plan.AttributeSets.Num(), 1);
+
+	// Reinstancing a class used by the plan must drop the plan, so grants never use a stale CDO
+#if WITH_EDITOR
+	AbilitySet->HandleObjectsReinstanced(TMap<UObject*, UObject*>());
+	TestFalse(TEXT("Plan is dropped on reinstancing"), AbilitySet->GrantPlan.bIsBuilt);
+#endif
+
+	AbilitySet->GrantedGameplayAbilities.SetNum(1);
+	AbilitySet->GrantPlan.Reset();
+	TestEqual(TEXT("Plan is rebuilt from the current data"), AbilitySet->GetGrantPlan().Abilities.Num(), 1);
+
+	AbilitySet->MarkAsGarbage();
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
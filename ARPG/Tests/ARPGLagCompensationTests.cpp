@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "ARPG/Abilities/ARPGLagCompensationSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Fills a capsule history with synthetic characters walking in circles, until the ring has wrapped, and checks
+ * single character rewinds against the synthetic paths and rewind-all segment queries against a brute force search.
+ * Reports the cost of recording and querying.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FARPGCapsuleHistoryTest, "ARPG.Abilities.LagCompensation.CapsuleHistory",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FARPGCapsuleHistoryTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumCharacters = 500;
+	constexpr int32 NumQueries = 10000;
+	constexpr double HistorySeconds = 1.0;
+	constexpr double SampleRate = 60.0;
+	constexpr float CapsuleRadius = 34.f;
+	constexpr float CapsuleHalfHeight = 90.f;
+	constexpr float BladeRadius = 5.f;
+
+	constexpr float Spacing = 200.f;
+	constexpr float WalkRadius = 50.f;
+	const int32 GridWidth = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+
+	auto LocationAt = [&](int32 Character, double Time)
+		{
+			const double Angle = Time * 2.0 + Character;
+			return FVector((Character % GridWidth) * Spacing + FMath::Cos(Angle) * WalkRadius, (Character / GridWidth) * Spacing + FMath::Sin(Angle) * WalkRadius, 90.f);
+		};
+
+	FARPGCapsuleHistory History;
+	History.Configure(FMath::CeilToInt(HistorySeconds * SampleRate) + 1);
+	for (int32 Character = 0; Character < NumCharacters; ++Character)
+	{
+		History.AddSlot(CapsuleRadius, CapsuleHalfHeight);
+	}
+
+	// Record twice the history so the ring has wrapped
+	const int32 NumFrames = FMath::CeilToInt(2.0 * HistorySeconds * SampleRate);
+	const double RecordStart = FPlatformTime::Seconds();
+	double Now = 0.0;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Now = Frame / SampleRate;
+		TArrayView<FVector3f> Locations = History.AddFrame(Now);
+		for (int32 Character = 0; Character < NumCharacters; ++Character)
+		{
+			Locations[Character] = FVector3f(LocationAt(Character, Now));
+		}
+	}
+	const double RecordSeconds = FPlatformTime::Seconds() - RecordStart;
+
+	TestEqual(TEXT("History keeps its capacity once wrapped"), History.GetNumFrames(), FMath::CeilToInt(HistorySeconds * SampleRate) + 1);
+
+	FRandomStream Random(1234);
+
+	// Single character rewinds. Between two frames the walkers deviate from the chord by less than a hundredth of a unit.
+	double MaxError = 0.0;
+	const double RewindStart = FPlatformTime::Seconds();
+	for (int32 Query = 0; Query < NumQueries; ++Query)
+	{
+		const int32 Character = Random.RandHelper(NumCharacters);
+		const double Time = Now - Random.FRand() * HistorySeconds;
+
+		FVector Location;
+		if (TestTrue(TEXT("Rewind finds the character"), History.GetLocationAtTime(Character, Time, Location)))
+		{
+			MaxError = FMath::Max(MaxError, FVector::Dist(Location, LocationAt(Character, Time)));
+		}
+	}
+	const double RewindSeconds = FPlatformTime::Seconds() - RewindStart;
+
+	TestTrue(FString::Printf(TEXT("Rewind error %f is below 0.1 units"), MaxError), MaxError < 0.1);
+
+	// Times older than the history clamp to the oldest frame
+	const double OldestTime = Now - (History.GetNumFrames() - 1) / SampleRate;
+	FVector ClampedLocation;
+	History.GetLocationAtTime(0, -100.0, ClampedLocation);
+	TestTrue(TEXT("Rewinds before the history clamp to the oldest frame"), ClampedLocation.Equals(LocationAt(0, OldestTime), 0.01));
+
+	// Rewind everyone and sweep a blade sized segment through a random spot of the grid, then compare with a brute force search
+	TArray<FARPGCapsuleHistory::FSegmentHit> Hits;
+	int32 TotalHits = 0;
+	int32 NumMismatches = 0;
+	double QuerySeconds = 0.0;
+	for (int32 Query = 0; Query < NumQueries; ++Query)
+	{
+		const double Time = Now - Random.FRand() * HistorySeconds;
+		const FVector Start(Random.FRandRange(0.f, GridWidth * Spacing), Random.FRandRange(0.f, GridWidth * Spacing), 90.f);
+		const FVector End = Start + Random.GetUnitVector().GetSafeNormal2D() * 150.f;
+
+		Hits.Reset();
+		const double QueryStart = FPlatformTime::Seconds();
+		History.QuerySegment(Time, Start, End, BladeRadius, Hits);
+		QuerySeconds += FPlatformTime::Seconds() - QueryStart;
+		TotalHits += Hits.Num();
+
+		for (int32 Character = 0; Character < NumCharacters; ++Character)
+		{
+			FVector Center;
+			History.GetLocationAtTime(Character, Time, Center);
+
+			const FVector AxisOffset(0.f, 0.f, CapsuleHalfHeight - CapsuleRadius);
+			FVector SegmentPoint;
+			FVector AxisPoint;
+			FMath::SegmentDistToSegmentSafe(Start, End, Center - AxisOffset, Center + AxisOffset, SegmentPoint, AxisPoint);
+			const double Distance = FVector::Dist(SegmentPoint, AxisPoint);
+
+			// Ignore grazing contacts, where rounding decides
+			if (FMath::IsNearlyEqual(Distance, static_cast<double>(CapsuleRadius + BladeRadius), 0.01))
+			{
+				continue;
+			}
+
+			const bool bExpected = Distance < CapsuleRadius + BladeRadius;
+			const bool bFound = Hits.ContainsByPredicate([Character](const FARPGCapsuleHistory::FSegmentHit& Hit) { return Hit.Slot == Character; });
+			if (bExpected != bFound)
+			{
+				++NumMismatches;
+			}
+		}
+	}
+
+	TestEqual(TEXT("Segment queries match the brute force search"), NumMismatches, 0);
+
+	AddInfo(FString::Printf(TEXT("%d characters, %d frames of history, %d KB of locations"),
+		NumCharacters, History.GetNumFrames(), static_cast<int32>(History.GetNumFrames() * History.GetSlotCapacity() * sizeof(FVector3f) / 1024)));
+	AddInfo(FString::Printf(TEXT("Record %.2f us per frame, single rewind %.3f us, rewind-all segment query %.2f us (%.2f hits avg)"),
+		RecordSeconds * 1e6 / NumFrames, RewindSeconds * 1e6 / NumQueries, QuerySeconds * 1e6 / NumQueries, static_cast<double>(TotalHits) / NumQueries));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Animation/AnimMontage.h"
+#include "ARPG/Abilities/ARPGAbilityTask_PlayMontageAndWaitForEvent.h"
+#include "ARPG/Abilities/ARPGAnimNotifyStateWeaponTrace.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Checks which notifies the server triggers right away when it starts a predicted montage further in to catch up with
+ * the client: the instant notifies inside the skipped window, and none of those around it or the notify states.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FARPGMontageCatchUpNotifiesTest, "ARPG.Abilities.MontageTask.ServerCatchUpNotifies",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FARPGMontageCatchUpNotifiesTest::RunTest(const FString& Parameters)
+{
+	// The montage was requested from 0.1s and the server starts it at 0.3s
+	constexpr float RequestedStart = 0.1f;
+	constexpr float CaughtUpStart = 0.3f;
+
+	UAnimMontage* Montage = NewObject<UAnimMontage>();
+
+	auto AddNotify = [Montage](const TCHAR* Name, float Time) -> FAnimNotifyEvent&
+		{
+			FAnimNotifyEvent& NotifyEvent = Montage->Notifies.AddDefaulted_GetRef();
+			NotifyEvent.NotifyName = Name;
+			NotifyEvent.SetTime(Time);
+			return NotifyEvent;
+		};
+
+	AddNotify(TEXT("BeforeWindow"), 0.05f);
+	AddNotify(TEXT("AtRequestedStart"), RequestedStart);
+	AddNotify(TEXT("InsideWindow"), 0.2f);
+	AddNotify(TEXT("AtCaughtUpStart"), CaughtUpStart);
+	AddNotify(TEXT("AfterWindow"), 0.4f);
+
+	// Begins with the montage's first update, it's still running at the caught-up start
+	FAnimNotifyEvent& NotifyState = AddNotify(TEXT("StateInsideWindow"), 0.15f);
+	NotifyState.NotifyStateClass = NewObject<UARPGAnimNotifyStateWeaponTrace>(Montage);
+	NotifyState.SetDuration(0.5f);
+
+	TArray<const FAnimNotifyEvent*> SkippedNotifies;
+	UARPGAbilityTask_PlayMontageAndWaitForEvent::GetSkippedNotifies(*Montage, RequestedStart, CaughtUpStart, SkippedNotifies);
+
+	TArray<FName> SkippedNames;
+	for (const FAnimNotifyEvent* NotifyEvent : SkippedNotifies)
+	{
+		SkippedNames.Add(NotifyEvent->NotifyName);
+	}
+
+	TestEqual(TEXT("Two notifies are skipped by catching up"), SkippedNames.Num(), 2);
+	TestTrue(TEXT("A notify inside the catch-up window is triggered"), SkippedNames.Contains(TEXT("InsideWindow")));
+	TestTrue(TEXT("A notify at the requested start is triggered"), SkippedNames.Contains(TEXT("AtRequestedStart")));
+	TestFalse(TEXT("A notify before the requested start isn't triggered"), SkippedNames.Contains(TEXT("BeforeWindow")));
+	TestFalse(TEXT("A notify at the caught-up start is left to the montage"), SkippedNames.Contains(TEXT("AtCaughtUpStart")));
+	TestFalse(TEXT("A notify after the catch-up window isn't triggered"), SkippedNames.Contains(TEXT("AfterWindow")));
+	TestFalse(TEXT("Notify states are left to the montage"), SkippedNames.Contains(TEXT("StateInsideWindow")));
+
+	// Without catch-up nothing is skipped
+	SkippedNotifies.Reset();
+	UARPGAbilityTask_PlayMontageAndWaitForEvent::GetSkippedNotifies(*Montage, RequestedStart, RequestedStart, SkippedNotifies);
+	TestEqual(TEXT("An empty window skips no notify"), SkippedNotifies.Num(), 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
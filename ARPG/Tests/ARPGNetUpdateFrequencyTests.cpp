@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
+#include "ARPG/Core/ARPGNetUpdateFrequencySubsystem.h"
+#include "ARPGTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Drives an actor through the net update frequency policy by advancing world time and ticking the subsystem:
+ * boosted on registration, idle after ARPG.NetFrequency.BoostDuration, boosted again by BoostActor and while moving,
+ * capped by SetMaxNetUpdateFrequency. Replication itself is timed by ARPG.Bench.ServerReplication with bot clients.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FARPGNetUpdateFrequencyPolicyTest, "ARPG.Network.NetUpdateFrequency.BoostAndIdle",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FARPGNetUpdateFrequencyPolicyTest::RunTest(const FString& Parameters)
+{
+	constexpr float FullRate = 60.f;
+	constexpr float CappedRate = 20.f;
+	constexpr float TickSeconds = 0.1f;
+
+	IConsoleVariable* EnabledVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("ARPG.NetFrequency.Enabled"));
+	const IConsoleVariable* IdleRateVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("ARPG.NetFrequency.IdleRate"));
+	const IConsoleVariable* BoostDurationVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("ARPG.NetFrequency.BoostDuration"));
+	if (!TestTrue(TEXT("Net frequency console variables exist"), EnabledVariable && IdleRateVariable && BoostDurationVariable))
+	{
+		return false;
+	}
+
+	const bool bWasEnabled = EnabledVariable->GetBool();
+	EnabledVariable->Set(true, ECVF_SetByCode);
+	ON_SCOPE_EXIT
+	{
+		EnabledVariable->Set(bWasEnabled, ECVF_SetByCode);
+	};
+
+	const float IdleRate = FMath::Min(IdleRateVariable->GetFloat(), FullRate);
+	const float BoostDuration = BoostDurationVariable->GetFloat();
+
+	FARPGScopedTestWorld World(TEXT("ARPGNetUpdateFrequencyPolicyTest"));
+	UARPGNetUpdateFrequencySubsystem* NetFrequency = UARPGNetUpdateFrequencySubsystem::Get(World.Get());
+	if (!TestNotNull(TEXT("Net update frequency subsystem"), NetFrequency))
+	{
+		return false;
+	}
+
+	// The velocity of an actor is the velocity of its root component
+	AActor* Actor = World->SpawnActor<AActor>();
+	USceneComponent* Root = NewObject<USceneComponent>(Actor);
+	Actor->SetRootComponent(Root);
+	Root->RegisterComponent();
+	Actor->SetNetUpdateFrequency(FullRate);
+
+	// Moves world time forward and ticks the subsystem until the given number of seconds have passed
+	auto Advance = [&](float Seconds)
+		{
+			for (float Elapsed = 0.f; Elapsed < Seconds; Elapsed += TickSeconds)
+			{
+				World->TimeSeconds += TickSeconds;
+				NetFrequency->Tick(TickSeconds);
+			}
+		};
+
+	NetFrequency->RegisterActor(Actor);
+	NetFrequency->Tick(TickSeconds);
+	TestEqual(TEXT("Registered actors start boosted to their full rate"), Actor->GetNetUpdateFrequency(), FullRate);
+	TestEqual(TEXT("Stats count the registered actor"), NetFrequency->GetStats().NumActors, 1);
+	TestEqual(TEXT("Stats count the boosted actor"), NetFrequency->GetStats().NumBoosted, 1);
+
+	Advance(BoostDuration + TickSeconds);
+	TestEqual(TEXT("Actors without changes drop to the idle rate"), Actor->GetNetUpdateFrequency(), IdleRate);
+	TestEqual(TEXT("Stats count no boosted actor once idle"), NetFrequency->GetStats().NumBoosted, 0);
+	TestEqual(TEXT("Idle actors keep the idle rate as their minimum"), Actor->GetMinNetUpdateFrequency(), IdleRate);
+
+	NetFrequency->BoostActor(Actor);
+	TestEqual(TEXT("BoostActor restores the full rate"), Actor->GetNetUpdateFrequency(), FullRate);
+
+	NetFrequency->SetMaxNetUpdateFrequency(Actor, CappedRate);
+	TestEqual(TEXT("SetMaxNetUpdateFrequency caps a boosted actor right away"), Actor->GetNetUpdateFrequency(), CappedRate);
+
+	Advance(BoostDuration + TickSeconds);
+	TestEqual(TEXT("Capped actors drop to the idle rate"), Actor->GetNetUpdateFrequency(), FMath::Min(IdleRate, CappedRate));
+
+	// Movement has no event, the subsystem polls it every tick and keeps moving actors boosted
+	Root->ComponentVelocity = FVector(300.f, 0.f, 0.f);
+	Advance(BoostDuration * 2.f);
+	TestEqual(TEXT("Moving actors stay boosted"), Actor->GetNetUpdateFrequency(), CappedRate);
+
+	Root->ComponentVelocity = FVector::ZeroVector;
+	Advance(BoostDuration + TickSeconds);
+	TestEqual(TEXT("Actors that stopped moving drop to the idle rate"), Actor->GetNetUpdateFrequency(), FMath::Min(IdleRate, CappedRate));
+
+	NetFrequency->UnregisterActor(Actor);
+	NetFrequency->Tick(TickSeconds);
+	TestEqual(TEXT("Unregistered actors leave the stats"), NetFrequency->GetStats().NumActors, 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
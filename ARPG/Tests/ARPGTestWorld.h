@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Game world created for the duration of a test, with its physics scene and subsystems, and destroyed with the scope.
+ * Actors are initialized for play but BeginPlay isn't called, call BeginPlay() if the test needs it.
+ */
+struct FARPGScopedTestWorld
+{
+	explicit FARPGScopedTestWorld(const TCHAR* Name)
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, /* bInformEngineOfWorld = */ false, Name);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+	}
+
+	~FARPGScopedTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(/* bInformEngineOfWorld = */ false);
+	}
+
+	FARPGScopedTestWorld(const FARPGScopedTestWorld&) = delete;
+	FARPGScopedTestWorld& operator=(const FARPGScopedTestWorld&) = delete;
+
+	void BeginPlay()
+	{
+		World->BeginPlay();
+	}
+
+	UWorld* operator->() const { return World; }
+	UWorld* Get() const { return World; }
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
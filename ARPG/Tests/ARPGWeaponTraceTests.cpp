@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Components/SphereComponent.h"
+#include "ARPG/Abilities/ARPGAnimNotifyStateWeaponTrace.h"
+#include "ARPGTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Plays a synthetic 180 degree swing against a ring of targets at several tick rates through the notify's real
+ * SweepBlade, and fails if any rate hits different targets, or misses targets inside the swing arc.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FARPGWeaponTraceFrameRateTest, "ARPG.Abilities.WeaponTrace.FrameRateIndependence",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FARPGWeaponTraceFrameRateTest::RunTest(const FString& Parameters)
+{
+	constexpr float SwingDuration = 0.3f;
+
+	// Thin blade pivoting around the origin, from 50 to 150 units out, sweeping from -90 to 90 degrees
+	constexpr float BladeInner = 50.f;
+	constexpr float BladeOuter = 150.f;
+	constexpr float BladeHalfThickness = 5.f;
+	constexpr float TargetRadius = 10.f;
+	constexpr float TargetRingRadius = 100.f;
+
+	FARPGScopedTestWorld World(TEXT("ARPGWeaponTraceFrameRateTest"));
+
+	// Targets every 7 degrees, some of them outside the swing arc
+	TArray<AActor*> Targets;
+	TArray<float> TargetAngles;
+	for (float Degrees = -120.f; Degrees <= 120.f; Degrees += 7.f)
+	{
+		AActor* Target = World->SpawnActor<AActor>();
+		USphereComponent* Sphere = NewObject<USphereComponent>(Target);
+		Sphere->InitSphereRadius(TargetRadius);
+		Sphere->SetCollisionObjectType(ECC_Pawn);
+		Sphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Sphere->SetCollisionResponseToAllChannels(ECR_Overlap);
+		Target->SetRootComponent(Sphere);
+		Sphere->RegisterComponent();
+		Sphere->SetWorldLocation(FQuat(FVector::UpVector, FMath::DegreesToRadians(Degrees)).RotateVector(FVector(TargetRingRadius, 0.f, 0.f)));
+
+		Targets.Add(Target);
+		TargetAngles.Add(Degrees);
+	}
+
+	UARPGAnimNotifyStateWeaponTrace* Notify = NewObject<UARPGAnimNotifyStateWeaponTrace>();
+	Notify->WeaponTraceBoxHalfExtent = FVector(BladeHalfThickness);
+
+	auto PoseAt = [&](float Time)
+		{
+			const float Angle = FMath::DegreesToRadians(FMath::Lerp(-90.f, 90.f, FMath::Clamp(Time / SwingDuration, 0.f, 1.f)));
+			const FQuat Rotation(FVector::UpVector, Angle);
+			return FARPGWeaponBladePose(Rotation.RotateVector(FVector(BladeInner, 0.f, 0.f)), Rotation.RotateVector(FVector(BladeOuter, 0.f, 0.f)), Rotation);
+		};
+
+	// The tip of this thin blade moves ~1570 units per second, so the default MaxSubsteps only covers it down to ~10 Hz
+	const float TickRates[] = { 15.f, 30.f, 60.f, 144.f };
+	TArray<TBitArray<>> HitSets;
+
+	for (const float TickRate : TickRates)
+	{
+		// Same sequence of calls as the notify: begin pose, one sweep per tick, last sweep on notify end
+		FARPGWeaponTraceState State;
+		State.CollisionObjectQueryParams.AddObjectTypesToQuery(ECC_Pawn);
+		State.CollisionQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponTraceTest), false);
+		State.WeaponTraceShape = FCollisionShape::MakeBox(Notify->WeaponTraceBoxHalfExtent);
+		State.PreviousBladePose = PoseAt(0.f);
+
+		TBitArray<> Hits(false, Targets.Num());
+		auto SweepTo = [&](float Time)
+			{
+				Notify->SweepBlade(World.Get(), State, PoseAt(Time));
+				for (const FHitResult& HitResult : State.HitResults)
+				{
+					const int32 TargetIndex = Targets.IndexOfByKey(HitResult.GetActor());
+					if (TargetIndex != INDEX_NONE)
+					{
+						Hits[TargetIndex] = true;
+					}
+				}
+			};
+
+		for (float Time = 1.f / TickRate; Time < SwingDuration; Time += 1.f / TickRate)
+		{
+			SweepTo(Time);
+		}
+		SweepTo(SwingDuration);
+
+		for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); ++TargetIndex)
+		{
+			if (FMath::Abs(TargetAngles[TargetIndex]) <= 90.f && !Hits[TargetIndex])
+			{
+				AddError(FString::Printf(TEXT("%.0f Hz missed the target at %.0f degrees, inside the swing arc"), TickRate, TargetAngles[TargetIndex]));
+			}
+		}
+
+		AddInfo(FString::Printf(TEXT("%.0f Hz hit %d/%d targets"), TickRate, Hits.CountSetBits(), Targets.Num()));
+		HitSets.Add(MoveTemp(Hits));
+	}
+
+	for (int32 Index = 1; Index < HitSets.Num(); ++Index)
+	{
+		TestTrue(FString::Printf(TEXT("Hit set at %.0f Hz matches %.0f Hz"), TickRates[Index], TickRates[0]), HitSets[Index] == HitSets[0]);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS